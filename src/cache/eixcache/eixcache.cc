@@ -196,7 +196,12 @@ void EixCache::get_package(Package *p) {
 				pkg = new Package(p->category, p->name);
 			}
 		}
-		pkg->addVersion(version);
+		if(have_pkg) {
+			pkg->addVersion(version);
+		} else {
+			// The versions of the eix cache are sorted
+			pkg->appendVersion(version);
+		}
 		if(*(pkg->latest()) == *version) {
 			pkg->homepage = p->homepage;
 			pkg->licenses = p->licenses;
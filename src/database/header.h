@@ -21,6 +21,7 @@
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
+#include "portage/iuse.h"
 #include "portage/overlay.h"
 
 class PortageSettings;
@@ -37,6 +38,8 @@ class DBHeader {
 		**/
 		OverlayVec overlays;
 
+		mutable IUseSet::IUseStd m_iuse_table;
+
 	public:
 		StringHash
 			eapi_hash,
@@ -75,7 +78,7 @@ class DBHeader {
 		/**
 		Current version of database-format and what we accept
 		**/
-		static CONSTEXPR const DBVersion current = 38;
+		static CONSTEXPR const DBVersion current = 40;
 		static const DBHeader::DBVersion accept[];
 
 		/**
@@ -102,6 +105,18 @@ class DBHeader {
 		**/
 		void set_priorities(PortageSettings *ps);
 
+		/**
+		@return the entries of iuse_hash, parsed and interned on first use
+		**/
+		const IUseSet::IUseStd& iuse_table() const;
+
+		/**
+		Must be called when iuse_hash is modified
+		**/
+		void reset_iuse_table() {
+			m_iuse_table.clear();
+		}
+
 		/**
 		Find first overlay-number >=minimal for name.
 		Name might be either a label, a filename, or a number string.
@@ -9,7 +9,9 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include "eixTk/likely.h"
+#include "eixTk/stringutils.h"
 #include "portage/conf/portagesettings.h"
+#include "portage/iuse.h"
 #include "portage/overlay.h"
 
 void DBHeader::set_priorities(PortageSettings *ps) {
@@ -18,3 +20,15 @@ void DBHeader::set_priorities(PortageSettings *ps) {
 		ps->repos.set_priority(&(*it));
 	}
 }
+
+const IUseSet::IUseStd& DBHeader::iuse_table() const {
+	if(unlikely(m_iuse_table.size() != iuse_hash.size())) {
+		m_iuse_table.clear();
+		m_iuse_table.reserve(iuse_hash.size());
+		for(StringHash::const_iterator it(iuse_hash.begin());
+			likely(it != iuse_hash.end()); ++it) {
+			m_iuse_table.PUSH_BACK(IUse(*it));
+		}
+	}
+	return m_iuse_table;
+}
@@ -8,7 +8,11 @@
 #include "database/io.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <cstdio>
+#include <cstdlib>
 
 #include <string>
 
@@ -52,6 +56,31 @@ bool File::openwrite(const char *name) {
 	return true;
 }
 
+bool File::opentemp(const string& name, string *tempname) {
+	string temp(name + ".XXXXXX");
+	int fd(mkstemp(&(temp[0])));
+	if(fd == -1) {
+		return false;
+	}
+	fchmod(fd, 0644);
+	if((fp = fdopen(fd, "wb")) == NULLPTR) {
+		close(fd);
+		unlink(temp.c_str());
+		return false;
+	}
+	*tempname = temp;
+	return true;
+}
+
+bool File::closewrite() {
+	if(unlikely(fp == NULLPTR)) {
+		return false;
+	}
+	bool ok(std::fclose(fp) == 0);
+	fp = NULLPTR;
+	return ok;
+}
+
 void File::destroy() {
 	if(unlikely(fp == NULLPTR)) {
 		return;
@@ -64,6 +93,7 @@ void File::destroy() {
 #endif
 #endif
 	std::fclose(fp);
+	fp = NULLPTR;
 }
 
 bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
@@ -105,6 +135,14 @@ bool File::write_string_plain(const string& str, string *errtext) {
 	return false;
 }
 
+bool File::write_string_plain(const char *s, string::size_type len, string *errtext) {
+	if(likely(write(s, len))) {
+		return true;
+	}
+	writeError(errtext);
+	return false;
+}
+
 void File::readError(string *errtext) {
 	if(errtext != NULLPTR) {
 		*errtext = (feof(fp) ?
@@ -149,6 +187,16 @@ GCC_DIAG_ON(sign-conversion)
 	return File::write_string_plain(str, errtext);
 }
 
+bool Database::write_string_plain(const char *s, string::size_type len, string *errtext) {
+	if(counting) {
+GCC_DIAG_OFF(sign-conversion)
+		counter += len;
+GCC_DIAG_ON(sign-conversion)
+		return true;
+	}
+	return File::write_string_plain(s, len, errtext);
+}
+
 bool Database::read_string(string *s, string *errtext) {
 	string::size_type len;
 	if(unlikely(!read_num(&len, errtext))) {
@@ -13,6 +13,7 @@
 #include <cstdio>
 
 #include <string>
+#include <vector>
 
 #include "database/header.h"
 #include "eixTk/attribute.h"
@@ -27,6 +28,8 @@
 // check_includes: include "portage/basicversion.h"
 
 class BasicPart;
+class BasicVersion;
+class Category;
 class IUseSet;
 class Package;
 class PackageReader;
@@ -70,6 +73,18 @@ class File {
 		ATTRIBUTE_NONNULL_ bool openread(const char *name);
 		ATTRIBUTE_NONNULL_ bool openwrite(const char *name);
 
+		/**
+		Create and open a new file name.XXXXXX with mode 0644 for writing
+		@param tempname is set to the name of the file
+		**/
+		ATTRIBUTE_NONNULL_ bool opentemp(const std::string& name, std::string *tempname);
+
+		/**
+		Close a file opened for writing
+		@return false if not all data could be written
+		**/
+		bool closewrite();
+
 		int getch() {
 			return std::fgetc(fp);
 		}
@@ -86,8 +101,13 @@ class File {
 			return (std::fwrite(static_cast<const void *>(str.c_str()), sizeof(*(str.c_str())), str.size(), fp) == str.size());
 		}
 
+		bool write(const char *s, std::string::size_type len) {
+			return (std::fwrite(static_cast<const void *>(s), sizeof(*s), len, fp) == len);
+		}
+
 		ATTRIBUTE_NONNULL((2)) bool read_string_plain(char *s, std::string::size_type len, std::string *errtext);
 		bool write_string_plain(const std::string& str, std::string *errtext);
+		ATTRIBUTE_NONNULL((2)) bool write_string_plain(const char *s, std::string::size_type len, std::string *errtext);
 
 		bool seekrel(eix::OffsetType offset, std::string *errtext) {
 			return seek(offset, SEEK_CUR, errtext);
@@ -110,9 +130,10 @@ class Database : public File {
 		bool counting;
 		eix::OffsetType counter;
 
-		ATTRIBUTE_NONNULL((2)) bool read_Part(BasicPart *b, std::string *errtext);
+		ATTRIBUTE_NONNULL((2)) bool read_Part(BasicVersion *v, std::string *errtext);
 		bool write_Part(const BasicPart& n, std::string *errtext);
 		bool write_string_plain(const std::string& str, std::string *errtext);
+		ATTRIBUTE_NONNULL((2)) bool write_string_plain(const char *s, std::string::size_type len, std::string *errtext);
 
 	protected:
 		bool readUChar(eix::UChar *c, std::string *errtext);
@@ -157,7 +178,7 @@ class Database : public File {
 		ATTRIBUTE_NONNULL((3)) bool read_hash_words(const StringHash& hash, std::string *s, std::string *errtext);
 		bool read_hash_words(std::string *errtext);
 
-		ATTRIBUTE_NONNULL((3)) bool read_iuse(const StringHash& hash, IUseSet *iuse, std::string *errtext);
+		ATTRIBUTE_NONNULL((3)) bool read_iuse(const DBHeader& hdr, IUseSet *iuse, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2)) bool read_version(Version *v, const DBHeader& hdr, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool write_version(const Version *v, const DBHeader& hdr, std::string *errtext);
@@ -166,11 +187,24 @@ class Database : public File {
 		bool write_depend(const Depend& dep, const DBHeader& hdr, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2, 3)) bool read_category_header(std::string *name, eix::Treesize *h, std::string *errtext);
-		bool write_category_header(const std::string& name, eix::Treesize size, std::string *errtext);
+		bool write_category_header(const std::string& name, eix::Treesize size, eix::OffsetType len, std::string *errtext);
+		bool write_category_index(Category *cat, const std::vector<eix::OffsetType>& offsets, const std::vector<std::string>& checksums, std::string *errtext);
 
 		bool write_package(const Package& pkg, const DBHeader& hdr, std::string *errtext);
 		bool write_package_pure(const Package& pkg, const DBHeader& hdr, std::string *errtext);
 
+		/**
+		@return the number of bytes which write_package would write
+		**/
+		eix::OffsetType package_size(const Package& pkg, const DBHeader& hdr);
+
+		/**
+		@return the checksum of the package for the index.
+		It is independent of the hashes of hdr so that it can be
+		compared with the checksums of another database.
+		**/
+		static std::string package_checksum(const Package& pkg, const DBHeader& hdr);
+
 		bool write_hash(const StringHash& hash, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool read_hash(StringHash *hash, std::string *errtext);
 
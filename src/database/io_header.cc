@@ -99,6 +99,7 @@ GCC_DIAG_ON(sign-conversion)
 	if(unlikely(!read_hash(&(hdr->iuse_hash), errtext))) {
 		return false;
 	}
+	hdr->reset_iuse_table();
 	if(unlikely(!read_hash(&(hdr->slot_hash), errtext))) {
 		return false;
 	}
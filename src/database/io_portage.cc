@@ -9,6 +9,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "database/header.h"
 #include "database/package_reader.h"
@@ -16,6 +17,7 @@
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
+#include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
@@ -30,6 +32,7 @@
 #include "portage/version.h"
 
 using std::string;
+using std::vector;
 
 #define WRITE_COUNTER(f) do { \
 	eix::OffsetType counter_save(counter); \
@@ -45,39 +48,39 @@ using std::string;
 	} \
 } while(0)
 
-bool Database::read_Part(BasicPart *b, string *errtext) {
-	string::size_type len;
-	if(unlikely(!read_num(&len, errtext))) {
+bool Database::read_Part(BasicVersion *v, string *errtext) {
+	string::size_type num;
+	if(unlikely(!read_num(&num, errtext))) {
 		return false;
 	}
-	BasicPart::PartType type(BasicPart::PartType(len % BasicPart::max_type));
-	len /= BasicPart::max_type;
+	v->add_part_header(num);
+	string::size_type len(num / BasicPart::max_type);
 	if(len != 0) {
-		eix::auto_array<char> buf(new char[len + 1]);
-		buf.get()[len] = 0;
-		if(unlikely(!read_string_plain(buf.get(), len, errtext))) {
+		string& parts(v->m_parts);
+		string::size_type pos(parts.size());
+		parts.resize(pos + len);
+		if(unlikely(!read_string_plain(&(parts[pos]), len, errtext))) {
 			return false;
 		}
-		*b = BasicPart(type, string(buf.get()));
-		return true;
 	}
-	*b = BasicPart(type);
 	return true;
 }
 
-bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext) {
+bool Database::read_iuse(const DBHeader& hdr, IUseSet *iuse, string *errtext) {
 	iuse->clear();
+	const IUseSet::IUseStd& table(hdr.iuse_table());
 	eix::UNumber e;
 	if(unlikely(!read_num(&e, errtext))) {
 		return false;
 	}
 	for(; e; --e) {
-		string s;
-		if(unlikely(!read_hash_string(hash, &s, errtext))) {
+		IUseSet::IUseStd::size_type i;
+		if(unlikely(!read_num(&i, errtext))) {
 			return false;
 		}
-		iuse->insert_fast(s);
+		iuse->push_back(table[i]);
 	}
+	iuse->finalize();
 	return true;
 }
 
@@ -109,18 +112,17 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	}
 
 	// read primary version part
-	BasicVersion::PartsType::size_type i;
+	eix::UNumber i;
 	if(unlikely(!read_num(&i, errtext))) {
 		return false;
 	}
-	v->m_parts.reserve(i);
+	v->m_parts.clear();
 	for(; likely(i != 0); --i) {
-		BasicPart b;
-		if(unlikely(!read_Part(&b, errtext))) {
+		if(unlikely(!read_Part(v, errtext))) {
 			return false;
 		}
-		v->m_parts.PUSH_BACK(MOVE(b));
 	}
+	v->calc_key();
 
 	string fullslot;
 	if(unlikely(!read_hash_string(hdr.slot_hash, &fullslot, errtext))) {
@@ -134,7 +136,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	v->reponame = overlay.label;
 	v->priority = overlay.priority;
 
-	if(unlikely(!read_iuse(hdr.iuse_hash, &(v->iuse), errtext))) {
+	if(unlikely(!read_iuse(hdr, &(v->iuse), errtext))) {
 		return false;
 	}
 	if(hdr.use_required_use) {
@@ -171,12 +173,11 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 }
 
 bool Database::write_Part(const BasicPart& n, string *errtext) {
-	const string& content(n.partcontent);
-	if(unlikely(!write_num(content.size()*BasicPart::max_type + string::size_type(n.parttype), errtext))) {
+	if(unlikely(!write_num(n.partsize*BasicPart::max_type + string::size_type(n.parttype), errtext))) {
 		return false;
 	}
-	if(!content.empty()) {
-		if(unlikely(!write_string_plain(content, errtext))) {
+	if(n.partsize != 0) {
+		if(unlikely(!write_string_plain(n.partcontent, n.partsize, errtext))) {
 			return false;
 		}
 	}
@@ -206,12 +207,15 @@ bool Database::write_version(const Version *v, const DBHeader& hdr, string *errt
 	}
 
 	// write m_primsplit
-	if(unlikely(!write_num(v->m_parts.size(), errtext))) {
+	eix::UNumber count(0);
+	for(BasicVersion::PartIterator it(v->m_parts); likely(!it.at_end()); ++it) {
+		++count;
+	}
+	if(unlikely(!write_num(count, errtext))) {
 		return false;
 	}
 
-	for(BasicVersion::PartsType::const_iterator it(v->m_parts.begin());
-		likely(it != v->m_parts.end()); ++it) {
+	for(BasicVersion::PartIterator it(v->m_parts); likely(!it.at_end()); ++it) {
 		if(unlikely(!write_Part(*it, errtext))) {
 			return false;
 		}
@@ -289,9 +293,27 @@ bool Database::read_category_header(string *name, eix::Treesize *h, string *errt
 		likely(read_num(h, errtext)));
 }
 
-bool Database::write_category_header(const string& name, eix::Treesize size, string *errtext) {
+bool Database::write_category_header(const string& name, eix::Treesize size, eix::OffsetType len, string *errtext) {
 	return (likely(write_string(name, errtext)) &&
-		likely(write_num(size, errtext)));
+		likely(write_num(size, errtext)) &&
+		likely(write_num(len, errtext)));
+}
+
+bool Database::write_category_index(Category *cat, const vector<eix::OffsetType>& offsets, const vector<string>& checksums, string *errtext) {
+	vector<eix::OffsetType>::const_iterator o(offsets.begin());
+	vector<string>::const_iterator c(checksums.begin());
+	for(Category::iterator p(cat->begin()); likely(p != cat->end()); ++p, ++o, ++c) {
+		if(unlikely(!write_string(p->name, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(*o, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_string(*c, errtext))) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool Database::write_package_pure(const Package& pkg, const DBHeader& hdr, string *errtext) {
@@ -326,6 +348,105 @@ bool Database::write_package(const Package& pkg, const DBHeader& hdr, string *er
 	return write_package_pure(pkg, hdr, errtext);
 }
 
+eix::OffsetType Database::package_size(const Package& pkg, const DBHeader& hdr) {
+	eix::OffsetType counter_save(counter);
+	counter = 0;
+	bool counting_save(counting);
+	counting = true;
+	write_package(pkg, hdr, NULLPTR);
+	counting = counting_save;
+	eix::OffsetType size(counter);
+	counter = counter_save;
+	return size;
+}
+
+/**
+FNV-1a hash of the data fed into it
+**/
+class PackageChecksum {
+	private:
+		uint64_t m_hash;
+
+	public:
+		PackageChecksum() : m_hash((static_cast<uint64_t>(0xCBF29CE4U) << 32) | 0x84222325U) {
+		}
+
+		void add(const char *s, string::size_type len) {
+			const uint64_t prime((static_cast<uint64_t>(0x100U) << 32) | 0x1B3U);
+			for(; likely(len != 0); --len) {
+				m_hash ^= static_cast<eix::UChar>(*(s++));
+				m_hash *= prime;
+			}
+		}
+
+		void add(eix::UNumber n) {
+			char buf[sizeof(n)];
+			for(size_t i(0); likely(i != sizeof(n)); ++i) {
+				buf[i] = static_cast<char>(n & 0xFFU);
+				n >>= 8;
+			}
+			add(buf, sizeof(n));
+		}
+
+		/**
+		Add the length first so that concatenations cannot collide
+		**/
+		void add(const string& s) {
+			add(eix::UNumber(s.size()));
+			add(s.c_str(), s.size());
+		}
+
+		void add(const WordVec& words) {
+			add(eix::UNumber(words.size()));
+			for(WordVec::const_iterator it(words.begin()); likely(it != words.end()); ++it) {
+				add(*it);
+			}
+		}
+
+		string get() const {
+			string r;
+			uint64_t h(m_hash);
+			for(int i(0); likely(i != 8); ++i) {
+				r.append(1, static_cast<char>(h & 0xFFU));
+				h >>= 8;
+			}
+			return r;
+		}
+};
+
+string Database::package_checksum(const Package& pkg, const DBHeader& hdr) {
+	PackageChecksum c;
+	c.add(pkg.name);
+	c.add(pkg.desc);
+	c.add(pkg.homepage);
+	c.add(pkg.licenses);
+	c.add(eix::UNumber(pkg.size()));
+	for(Package::const_iterator it(pkg.begin()); likely(it != pkg.end()); ++it) {
+		c.add(it->getFull());
+		c.add(it->eapi.get());
+		c.add(eix::UNumber(it->maskflags.get()));
+		c.add(eix::UNumber(it->propertiesFlags));
+		c.add(eix::UNumber(it->restrictFlags));
+		c.add(it->get_full_keywords());
+		c.add(it->get_shortfullslot());
+		c.add(eix::UNumber(it->overlay_key));
+		c.add(it->iuse.asVector());
+		if(hdr.use_required_use) {
+			c.add(it->required_use);
+		}
+		if(hdr.use_depend) {
+			c.add(it->depend.m_depend);
+			c.add(it->depend.m_rdepend);
+			c.add(it->depend.m_pdepend);
+			c.add(it->depend.m_bdepend);
+		}
+		if(hdr.use_src_uri) {
+			c.add(it->src_uri);
+		}
+	}
+	return c.get();
+}
+
 bool Database::write_hash(const StringHash& hash, string *errtext) {
 	StringHash::size_type e(hash.size());
 	if(unlikely(!write_num(e, errtext))) {
@@ -380,6 +501,7 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 	hdr->keywords_hash.finalize();
 	hdr->slot_hash.finalize();
 	hdr->iuse_hash.finalize();
+	hdr->reset_iuse_table();
 	if(use_dep) {
 		hdr->depend_hash.finalize();
 	}
@@ -455,10 +577,25 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 }
 
 bool Database::write_packagetree(const PackageTree& tree, const DBHeader& hdr, string *errtext) {
+	vector<eix::OffsetType> offsets;
+	vector<string> checksums;
 	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
 		Category *ci(c->second);
-		// Write category-header followed by a list of the packages.
-		if(unlikely(!write_category_header(c->first, eix::Treesize(ci->size()), errtext))) {
+		// Calculate the offsets and checksums of the packages for the index
+		offsets.clear();
+		checksums.clear();
+		eix::OffsetType len(0);
+		for(Category::iterator p(ci->begin()); likely(p != ci->end()); ++p) {
+			offsets.PUSH_BACK(len);
+			len += package_size(**p, hdr);
+			checksums.PUSH_BACK(package_checksum(**p, hdr));
+		}
+		// Write category-header and index followed by a list of the packages.
+		if(unlikely(!write_category_header(c->first, eix::Treesize(ci->size()), len, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_category_index(ci, offsets, checksums, NULLPTR));
+		if(unlikely(!write_category_index(ci, offsets, checksums, errtext))) {
 			return false;
 		}
 
@@ -10,15 +10,21 @@
 #include "database/package_reader.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <string>
+
 #include "database/io.h"
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "portage/conf/portagesettings.h"
 #include "portage/package.h"
+#include "portage/vardbpkg.h"
 #include "portage/version.h"
 
+using std::string;
+
 PackageReader::~PackageReader() {
 	delete m_pkg;
 }
@@ -77,16 +83,18 @@ bool PackageReader::read(Attributes need) {
 						m_error = true;
 						return false;
 					}
-					m_pkg->addVersion(v);
+					// The versions were written in sorted order
+					m_pkg->appendVersion(v);
 				}
 			}
 			if(likely(m_portagesettings != NULLPTR)) {
-				m_portagesettings->calc_local_sets(m_pkg);
-				m_portagesettings->finalize(m_pkg);
+				// Most packages read for a test are not printed:
+				// Postpone the local sets and masks until they are needed
+				m_pkg->m_pending_local = m_portagesettings;
 			} else {
 				m_pkg->finalize_masks();
+				m_pkg->save_maskflags(Version::SAVEMASK_FILE);
 			}
-			m_pkg->save_maskflags(Version::SAVEMASK_FILE);
 		default:
 		// case ALL:
 			break;
@@ -119,32 +127,127 @@ Package *PackageReader::release() {
 	return r;
 }
 
-bool PackageReader::next() {
-	if(unlikely(m_cat_size-- == 0)) {
-		if(unlikely(m_frames-- == 0)) {
-			return false;
-		}
-		if(unlikely(!m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
+bool PackageReader::next_category() {
+	if(unlikely(m_indexed)) {
+		m_indexed = false;
+		if(unlikely(!m_db->seekabs(m_cat_end, &m_errtext))) {
 			m_error = true;
 			return false;
 		}
-		return next();
 	}
-
-	eix::OffsetType len;
-	if(unlikely(!m_db->read_num(&len, &m_errtext))) {
+	if(unlikely(m_frames == 0)) {
+		return false;
+	}
+	--m_frames;
+	if(unlikely(!m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
 		m_error = true;
 		return false;
 	}
-	m_next = m_db->tell() + len;
-	m_have = NONE;
-	delete m_pkg;
-	m_pkg = new Package;
-	m_pkg->category = m_cat_name;
-
+	if(unlikely(header->version < 39)) {  // no index
+		return true;
+	}
+	eix::OffsetType len, index_len;
+	if(unlikely(!m_db->read_num(&len, &m_errtext)) ||
+		unlikely(!m_db->read_num(&index_len, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	bool with_checksums(header->version >= 40);
+	m_have_checksums = false;
+	if(likely(m_vardbpkg == NULLPTR) &&
+		(likely(!m_want_checksums) || unlikely(!with_checksums))) {
+		if(unlikely(!m_db->seekrel(index_len, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		return true;
+	}
+	if((m_vardbpkg != NULLPTR) && !m_vardbpkg->haveCategory(m_cat_name)) {
+		m_cat_size = 0;
+		if(unlikely(!m_db->seekrel(index_len + len, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		return true;
+	}
+	m_offsets.clear();
+	m_checksums.clear();
+	m_checksum_pos = 0;
+	string name, checksum;
+	for(eix::Treesize i(m_cat_size); likely(i != 0); --i) {
+		eix::OffsetType offset;
+		if(unlikely(!m_db->read_string(&name, &m_errtext)) ||
+			unlikely(!m_db->read_num(&offset, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		if(with_checksums && unlikely(!m_db->read_string(&checksum, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		if(m_vardbpkg == NULLPTR) {
+			m_checksums.PUSH_BACK(checksum);
+		} else if(m_vardbpkg->isInstalled(m_cat_name, name)) {
+			m_offsets.PUSH_BACK(offset);
+			if(m_want_checksums) {
+				m_checksums.PUSH_BACK(checksum);
+			}
+		}
+	}
+	m_have_checksums = (m_want_checksums && with_checksums);
+	if(m_vardbpkg == NULLPTR) {  // All packages are read sequentially
+		return true;
+	}
+	m_cat_size = m_offsets.size();
+	m_offset_pos = 0;
+	m_pkg_start = m_db->tell();
+	m_cat_end = m_pkg_start + len;
+	m_indexed = true;
 	return true;
 }
 
+bool PackageReader::next() {
+	for(;;) {
+		while(unlikely(m_cat_size == 0)) {
+			if(unlikely(!next_category())) {
+				return false;
+			}
+		}
+		--m_cat_size;
+		++m_checksum_pos;
+		if(unlikely(m_indexed)) {
+			if(unlikely(!m_db->seekabs(m_pkg_start + m_offsets[m_offset_pos++], &m_errtext))) {
+				m_error = true;
+				return false;
+			}
+		}
+
+		eix::OffsetType len;
+		if(unlikely(!m_db->read_num(&len, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		m_next = m_db->tell() + len;
+		m_have = NONE;
+		delete m_pkg;
+		m_pkg = new Package;
+		m_pkg->category = m_cat_name;
+		if(likely(m_vardbpkg == NULLPTR) || m_indexed) {
+			return true;
+		}
+		// Without index we have to look at the name
+		if(unlikely(!read(NAME))) {
+			return false;
+		}
+		if(m_vardbpkg->isInstalled(m_cat_name, m_pkg->name)) {
+			return true;
+		}
+		if(unlikely(!skip())) {
+			return false;
+		}
+	}
+}
+
 #if 0
 bool PackageReader::nextCategory() {
 	if(unlikely(m_frames-- == 0)) {
@@ -16,8 +16,10 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "database/header.h"
+#include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
 
@@ -25,6 +27,7 @@ class Database;
 class DBHeader;
 class Package;
 class PortageSettings;
+class VarDbPkg;
 
 /**
 Forward-iterate for packages stored in the cachefile
@@ -42,11 +45,11 @@ class PackageReader {
 		@arg ps is used to define the local package sets while version reading
 		**/
 		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_indexed(false), m_checksum_pos(0), m_want_checksums(false), m_have_checksums(false), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_vardbpkg(NULLPTR), m_error(false) {
 		}
 
 		PackageReader(Database *db, const DBHeader& hdr)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_indexed(false), m_checksum_pos(0), m_want_checksums(false), m_have_checksums(false), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_vardbpkg(NULLPTR), m_error(false) {
 		}
 
 		~PackageReader();
@@ -86,6 +89,32 @@ class PackageReader {
 		**/
 		bool next();
 
+		/**
+		Let next() skip all packages which are not installed according
+		to vardbpkg. Must be called before the first next().
+		If the database has a package index, only the installed packages
+		are read from it.
+		**/
+		ATTRIBUTE_NONNULL_ void set_installed_filter(VarDbPkg *vardbpkg) {
+			m_vardbpkg = vardbpkg;
+		}
+
+		/**
+		Read the checksums from the package index.
+		Must be called before the first next().
+		**/
+		void set_read_checksums() {
+			m_want_checksums = true;
+		}
+
+		/**
+		@return the checksum of the current package from the package index
+		or NULLPTR if the database has none
+		**/
+		const std::string *checksum() const {
+			return (m_have_checksums ? &(m_checksums[m_checksum_pos - 1]) : NULLPTR);
+		}
+
 #if 0
 		/**
 		Go into the next (or first) category part.
@@ -118,15 +147,38 @@ class PackageReader {
 		eix::Treesize     m_cat_size;
 		std::string       m_cat_name;
 
+		/**
+		Offsets (relative to m_pkg_start) of the packages still to be
+		read from the index of the current category
+		**/
+		std::vector<eix::OffsetType> m_offsets;
+		std::vector<eix::OffsetType>::size_type m_offset_pos;
+		eix::OffsetType   m_pkg_start, m_cat_end;
+		bool              m_indexed;
+
+		/**
+		Checksums of the packages still to be read in the current category
+		**/
+		std::vector<std::string> m_checksums;
+		std::vector<std::string>::size_type m_checksum_pos;
+		bool              m_want_checksums, m_have_checksums;
+
 		off_t             m_next;
 		Attributes        m_have;
 		Package          *m_pkg;
 
 		const DBHeader   *header;
 		PortageSettings  *m_portagesettings;
+		VarDbPkg         *m_vardbpkg;
 
 		std::string m_errtext;
 		bool m_error;
+
+		/**
+		Read the next category header (and index if needed).
+		@return false if there are none more or on error
+		**/
+		bool next_category();
 };
 
 #endif  // SRC_DATABASE_PACKAGE_READER_H_
@@ -28,6 +28,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/parseerror.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
@@ -38,6 +39,7 @@
 #include "portage/conf/portagesettings.h"
 #include "portage/depend.h"
 #include "portage/extendedversion.h"
+#include "portage/overlay.h"
 #include "portage/package.h"
 #include "portage/packagetree.h"
 #include "portage/set_stability.h"
@@ -52,6 +54,7 @@ using std::vector;
 static void print_help();
 ATTRIBUTE_NONNULL_ static void init_db(const char *file, Database *db, DBHeader *header, PackageReader **reader, PortageSettings *ps);
 ATTRIBUTE_NONNULL_ static void set_virtual(PrintFormat *fmt, const DBHeader& header, const string& eprefix_virtual);
+static bool same_overlays(const DBHeader& old_hdr, const DBHeader& new_hdr);
 ATTRIBUTE_NONNULL_ static void print_changed_package(Package *op, Package *np);
 ATTRIBUTE_NONNULL_ static void print_found_package(Package *p);
 ATTRIBUTE_NONNULL_ static void print_lost_package(Package *p);
@@ -173,9 +176,13 @@ class DiffReaders {
 		found_func found_package;
 		changed_func changed_package;
 
-		ATTRIBUTE_NONNULL_ DiffReaders(VarDbPkg *vardbpkg, PortageSettings *portage_settings, bool only_installed, bool compare_slots, bool separate_deleted) :
+		/**
+		@arg use_checksums: Packages with the same checksum in both
+		databases are not read but considered as unchanged
+		**/
+		ATTRIBUTE_NONNULL_ DiffReaders(VarDbPkg *vardbpkg, PortageSettings *portage_settings, bool only_installed, bool compare_slots, bool separate_deleted, bool use_checksums) :
 			m_vardbpkg(vardbpkg), m_portage_settings(portage_settings), m_only_installed(only_installed),
-			m_slots(compare_slots), m_separate_deleted(separate_deleted) {
+			m_slots(compare_slots), m_separate_deleted(separate_deleted), m_checksums(use_checksums) {
 		}
 
 		/**
@@ -221,8 +228,11 @@ class DiffReaders {
 				lost_list.clear();
 			}
 			while(doread_old()) {
-				lost_package(old_pkg);
-				delete(old_pkg);
+				Package *p(release_old());
+				if(likely(p != NULLPTR)) {
+					lost_package(p);
+					delete p;
+				}
 			}
 			if(m_separate_deleted) {
 				for(vector<Package *>::iterator it(found_list.begin());
@@ -233,8 +243,11 @@ class DiffReaders {
 				found_list.clear();
 			}
 			while(doread_new()) {
-				found_package(new_pkg);
-				delete(new_pkg);
+				Package *p(release_new());
+				if(likely(p != NULLPTR)) {
+					found_package(p);
+					delete p;
+				}
 			}
 			const char *err_cstr(old_reader->get_errtext());
 			if(likely(err_cstr == NULLPTR)) {
@@ -253,20 +266,24 @@ class DiffReaders {
 	private:
 		VarDbPkg *m_vardbpkg;
 		PortageSettings *m_portage_settings;
-		bool m_only_installed, m_slots, m_separate_deleted;
+		bool m_only_installed, m_slots, m_separate_deleted, m_checksums;
 
 		// These are actually local variables to diff() but used for the subsequent functions
 		bool old_read, new_read;
 		vector<Package *> lost_list, found_list;
+
+		/**
+		The current packages; only the names are read and they still
+		belong to the readers, see release_old() and release_new()
+		**/
 		Package *old_pkg, *new_pkg;
 
 		bool doread_old() {
 			if(likely(old_read)) {
-				if(likely(old_reader->next())) {
-					if(likely((old_pkg = old_reader->release()) != NULLPTR)) {
-						set_stability_old->set_stability(old_pkg);
-						return true;
-					}
+				if(likely(old_reader->next()) &&
+					likely(old_reader->read(PackageReader::NAME))) {
+					old_pkg = old_reader->get();
+					return true;
 				}
 				old_read = false;
 			}
@@ -275,48 +292,117 @@ class DiffReaders {
 
 		bool doread_new() {
 			if(likely(new_read)) {
-				if(likely(new_reader->next())) {
-					if(likely((new_pkg = new_reader->release()) != NULLPTR)) {
-						set_stability_new->set_stability(new_pkg);
-						return true;
-					}
+				if(likely(new_reader->next()) &&
+					likely(new_reader->read(PackageReader::NAME))) {
+					new_pkg = new_reader->get();
+					return true;
 				}
 				new_read = false;
 			}
 			return false;
 		}
 
-		bool best_differs() {
-			return new_pkg->differ(*old_pkg, m_vardbpkg, m_portage_settings, true, m_only_installed, m_slots);
+		/**
+		@return the completely read old_pkg (to be deleted by the caller)
+		or NULLPTR on error
+		**/
+		Package *release_old() {
+			Package *p(old_reader->release());
+			if(likely(p != NULLPTR)) {
+				set_stability_old->set_stability(p);
+			} else {
+				old_read = false;
+			}
+			return p;
+		}
+
+		Package *release_new() {
+			Package *p(new_reader->release());
+			if(likely(p != NULLPTR)) {
+				set_stability_new->set_stability(p);
+			} else {
+				new_read = false;
+			}
+			return p;
+		}
+
+		/**
+		@return true if the stored checksums of old_pkg and new_pkg agree
+		**/
+		bool same_checksums() const {
+			if(!m_checksums) {
+				return false;
+			}
+			const string *old_sum(old_reader->checksum());
+			const string *new_sum(new_reader->checksum());
+			return ((old_sum != NULLPTR) && (new_sum != NULLPTR) && (*old_sum == *new_sum));
 		}
 
 		void handle_equal_packages() {
-			if(unlikely(best_differs())) {
-				changed_package(old_pkg, new_pkg);
+			if(same_checksums()) {
+				if(unlikely(!old_reader->skip())) {
+					old_read = false;
+				}
+				if(unlikely(!new_reader->skip())) {
+					new_read = false;
+				}
+				return;
+			}
+			Package *op(release_old());
+			Package *np(release_new());
+			if(likely((op != NULLPTR) && (np != NULLPTR))) {
+				if(unlikely(np->differ(*op, m_vardbpkg, m_portage_settings, true, m_only_installed, m_slots))) {
+					changed_package(op, np);
+				}
 			}
-			delete old_pkg;
-			delete new_pkg;
+			delete op;
+			delete np;
 		}
 
 		void handle_old_package() {
+			Package *p(release_old());
+			if(unlikely(p == NULLPTR)) {
+				return;
+			}
 			if(m_separate_deleted) {
-				lost_list.PUSH_BACK(old_pkg);
+				lost_list.PUSH_BACK(p);
 			} else {
-				lost_package(old_pkg);
-				delete old_pkg;
+				lost_package(p);
+				delete p;
 			}
 		}
 
 		void handle_new_package() {
+			Package *p(release_new());
+			if(unlikely(p == NULLPTR)) {
+				return;
+			}
 			if(m_separate_deleted) {
-				found_list.PUSH_BACK(new_pkg);
+				found_list.PUSH_BACK(p);
 			} else {
-				found_package(new_pkg);
-				delete new_pkg;
+				found_package(p);
+				delete p;
 			}
 		}
 };
 
+/**
+The overlay numbers stored in the checksums of the packages have the same
+meaning only if the overlays of the databases agree
+**/
+static bool same_overlays(const DBHeader& old_hdr, const DBHeader& new_hdr) {
+	ExtendedVersion::Overlay count(old_hdr.countOverlays());
+	if(count != new_hdr.countOverlays()) {
+		return false;
+	}
+	for(ExtendedVersion::Overlay i(0); likely(i != count); ++i) {
+		if(old_hdr.getOverlay(i) != new_hdr.getOverlay(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 /*
  * Diff everything from old-tree with the according package from new-tree.
  * They diff if
@@ -349,7 +435,6 @@ static void parseFormat(Node **format, const char *varname, EixRc *rc) {
 int run_eix_diff(int argc, char *argv[]) {
 	// Initialize static classes
 	Eapi::init_static();
-	Category::init_static();
 	ExtendedVersion::init_static();
 	PortageSettings::init_static();
 	PrintFormat::init_static();
@@ -415,6 +500,7 @@ int run_eix_diff(int argc, char *argv[]) {
 	}
 
 	if(unlikely(cli_quiet)) {
+		OutputSink::flush();
 		if(!freopen(DEV_NULL, "w", stdout)) {
 			eix::say_error(_("cannot redirect to \"%s\"")) % DEV_NULL;
 			std::exit(EXIT_FAILURE);
@@ -453,6 +539,10 @@ int run_eix_diff(int argc, char *argv[]) {
 		rc.getBool("RESTRICT_INSTALLED"), rc.getBool("CARE_RESTRICT_INSTALLED"),
 		rc.getBool("USE_BUILD_TIME"));
 	varpkg_db->check_installed_overlays = rc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
+	const string& snapshot(rc["EIX_INSTALLED_SNAPSHOT"]);
+	if(!snapshot.empty()) {
+		varpkg_db->use_snapshot(snapshot);
+	}
 
 	bool local_settings(rc.getBool("LOCAL_PORTAGE_CONFIG"));
 	bool always_accept_keywords(rc.getBool("ALWAYS_ACCEPT_KEYWORDS"));
@@ -476,10 +566,19 @@ int run_eix_diff(int argc, char *argv[]) {
 	set_virtual(format_for_old, *old_header, eprefix_virtual);
 	set_virtual(format_for_new, *new_header, eprefix_virtual);
 
+	bool only_installed(rc.getBool("DIFF_ONLY_INSTALLED"));
+	// With DIFF_ONLY_INSTALLED the installed versions are compared instead
+	bool use_checksums(rc.getBool("DIFF_CHECKSUMS") && !only_installed &&
+		same_overlays(*old_header, *new_header));
+	if(use_checksums) {
+		old_reader->set_read_checksums();
+		new_reader->set_read_checksums();
+	}
 	DiffReaders differ(varpkg_db, portagesettings,
-		rc.getBool("DIFF_ONLY_INSTALLED"),
+		only_installed,
 		!rc.getBool("DIFF_NO_SLOTS"),
-		rc.getBool("DIFF_SEPARATE_DELETED"));
+		rc.getBool("DIFF_SEPARATE_DELETED"),
+		use_checksums);
 
 	differ.lost_package    = print_lost_package;
 	differ.found_package   = print_found_package;
@@ -29,6 +29,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/parseerror.h"
 #include "eixTk/percentage.h"
 #include "eixTk/statusline.h"
@@ -290,7 +291,6 @@ static bool stringstart_in_wordlist(const string& to_check, const WordVec& wordl
 int run_eix_update(int argc, char *argv[]) {
 	// Initialize static classes
 	Eapi::init_static();
-	Category::init_static();
 	ExtendedVersion::init_static();
 	PortageSettings::init_static();
 	exclude_args = new ExcludeArgs;
@@ -380,6 +380,7 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* Honour a wish for silence */
 	if(unlikely(quiet)) {
+		OutputSink::flush();
 		if(!freopen(DEV_NULL, "w", stdout)) {
 			eix::say_error(_("cannot redirect to \"%s\"")) % DEV_NULL;
 			return EXIT_FAILURE;
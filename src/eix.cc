@@ -32,6 +32,7 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/outputstring.h"
 #include "eixTk/parseerror.h"
 #include "eixTk/ptr_container.h"
@@ -45,6 +46,8 @@
 #include "output/formatstring-print.h"
 #include "output/formatstring.h"
 #include "output/print-formats.h"
+#include "output/print-jobs.h"
+#include "output/print-json.h"
 #include "output/print-proto.h"
 #include "output/print-xml.h"
 #include "portage/basicversion.h"
@@ -61,6 +64,7 @@
 #include "search/packagetest.h"
 #include "various/cli.h"
 #include "various/drop_permissions.h"
+#include "various/query_cache.h"
 
 #define VAR_DB_PKG "/var/db/pkg/"
 
@@ -71,6 +75,26 @@ using std::vector;
 
 typedef eix::ptr_container<vector<Package *> > PackageList;
 
+/**
+Packages of a PackageList indexed by category and name
+**/
+class PackageIndex {
+	private:
+		typedef UNORDERED_MAP<string, const Package *> NameMap;
+		typedef UNORDERED_MAP<string, NameMap> CatMap;
+		CatMap cat_map;
+		const PackageList *packagelist;
+
+	public:
+		explicit PackageIndex(const PackageList& list);
+
+		/**
+		@return true if some package matches m.
+		Only masks with a wildcard category need to test all packages.
+		**/
+		bool have_match(const Mask& m) const;
+};
+
 static void dump_help();
 ATTRIBUTE_NONNULL_ static bool opencache(Database *db, const char *filename, const char *tooltext);
 ATTRIBUTE_NONNULL((1, 2)) static bool print_overlay_table(PrintFormat *fmt, DBHeader *header, PrintFormat::OverlayUsed *overlay_used);
@@ -78,12 +102,14 @@ ATTRIBUTE_NONNULL_ static void parseFormat(const char *sourcename, const char *c
 ATTRIBUTE_NONNULL_ static void set_format(EixRc *rc);
 ATTRIBUTE_NONNULL_ static void setup_defaults(EixRc *rc, bool is_tty);
 ATTRIBUTE_NONNULL_ static bool is_current_dbversion(const char *filename, const char *tooltext);
+ATTRIBUTE_NONNULL_ static int run_query(EixRc *rc, PortageSettings *settings, const ArgumentReader& argreader, const string& cachefile, const char *tooltext, bool is_tty, bool only_printed);
+static bool reads_stdin(const ArgumentReader& argreader);
 static void print_wordvec(const WordVec& vec);
-static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty);
+static void print_unused(const string& filename, const string& excludefiles, const PackageIndex& packageindex, bool test_empty);
 static void print_removed(const string& dirname, const string& excludefiles, const PackageList& packagelist);
-inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist);
-inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist) {
-	print_unused(filename, excludefiles, packagelist, false);
+inline static void print_unused(const string& filename, const string& excludefiles, const PackageIndex& packageindex);
+inline static void print_unused(const string& filename, const string& excludefiles, const PackageIndex& packageindex) {
+	print_unused(filename, excludefiles, packageindex, false);
 }
 
 /**
@@ -155,6 +181,7 @@ static void dump_help() {
 "         --brief2 (toggle)  Print at most two packages then stop\n"
 "     --xml (toggle)         output results in XML format\n"
 "     --proto (toggle)       output results in protobuf format\n"
+"     --json (toggle)        output results as one JSON object per package\n"
 "     -c, --compact          compact search results\n"
 "     -v, --verbose          verbose search results\n"
 "     -N, --normal           ignores -c, -v, and DEFAULT_FORMAT\n"
@@ -329,6 +356,7 @@ static struct LocalOptions {
 		known_vars,
 		xml,
 		proto,
+		json,
 		test_unused,
 		do_debug,
 		ignore_etc_portage,
@@ -387,6 +415,7 @@ EixOptionList::EixOptionList() {
 	push_back(Option("normal",        'N',     Option::BOOLEAN_T,     &rc_options.normal_output));
 	push_back(Option("xml",           O_XML,   Option::BOOLEAN,       &rc_options.xml));
 	push_back(Option("proto",         O_PROTO, Option::BOOLEAN,       &rc_options.proto));
+	push_back(Option("json",          O_JSON,  Option::BOOLEAN,       &rc_options.json));
 	push_back(Option("help",          'h',     Option::BOOLEAN_T,     &rc_options.show_help));
 	push_back(Option("version",       'V',     Option::BOOLEAN_T,     &rc_options.show_version));
 	push_back(Option("dump",          O_DUMP,  Option::BOOLEAN_T,     &rc_options.dump_eixrc));
@@ -641,10 +670,216 @@ static void set_format(EixRc *rc) {
 	}
 }
 
+/**
+Print the matches and keep track of what was printed.
+Packages can be passed either while the database is read or afterwards.
+**/
+class MatchPrinter {
+	private:
+		DBHeader *header;
+		VarDbPkg *varpkg_db;
+		PortageSettings *portagesettings;
+		SetStability *stability;
+		EixRc *eixrc;
+		PrintFormats *print_formats;
+		PrintJobs *jobs;
+		PrintJobs::Packages batch;
+		PrintJobs::Packages::size_type batch_size;
+		bool done;
+
+		/**
+		Count a match which was printed if printed is true
+		@return true if no further packages are needed
+		**/
+		bool counted(bool printed);
+
+		/**
+		Print the matches collected for the worker processes
+		**/
+		void print_batch();
+
+	public:
+		PrintFormat::OverlayUsed overlay_used;
+		bool need_overlay_table, have_printed, reached_limit, over_limit;
+		PackageList::size_type count;
+		eix::Treesize limit;
+
+		/**
+		Whether packages passed to package() are deleted after printing
+		**/
+		bool delete_packages;
+
+		ATTRIBUTE_NONNULL_ MatchPrinter(DBHeader *dbheader, VarDbPkg *vardb, PortageSettings *settings, SetStability *stab, EixRc *rc, eix::Treesize lim) :
+			header(dbheader), varpkg_db(vardb), portagesettings(settings),
+			stability(stab), eixrc(rc), print_formats(NULLPTR), jobs(NULLPTR),
+			batch_size(0), done(false),
+			overlay_used(dbheader->countOverlays(), false),
+			need_overlay_table(false), have_printed(false),
+			reached_limit(false), over_limit(false), count(0), limit(lim),
+			delete_packages(false) {
+			format->set_overlay_used(&overlay_used, &need_overlay_table);
+		}
+
+		~MatchPrinter() {
+			delete print_formats;
+			delete jobs;
+		}
+
+		/**
+		Format the matches passed to package() in worker processes
+		@param workers the number of worker processes
+		**/
+		void set_jobs(unsigned int workers) {
+			jobs = new PrintJobs(format, workers);
+			batch_size = 256 * static_cast<PrintJobs::Packages::size_type>(workers);
+		}
+
+		/**
+		Must be called before the first package is passed
+		**/
+		void start();
+
+		/**
+		Handle a match (in the order of output)
+		@return true if no further packages are needed
+		**/
+		ATTRIBUTE_NONNULL_ bool package(Package *pkg);
+
+		/**
+		Print a match according to format
+		@return true if no further packages are needed
+		**/
+		ATTRIBUTE_NONNULL_ bool print(Package *pkg);
+
+		/**
+		Print the matches which are still waiting for a worker process.
+		Must be called before the overlay table is printed.
+		**/
+		void flush();
+
+		/**
+		Must be called after the last package was passed
+		**/
+		void finish();
+};
+
+void MatchPrinter::start() {
+	if(unlikely((rc_options.xml ? 1 : 0) + (rc_options.proto ? 1 : 0) + (rc_options.json ? 1 : 0) > 1)) {
+		eix::say_error(_("at most one of --xml, --proto, and --json may be specified"));
+		std::exit(EXIT_FAILURE);
+	}
+	if(rc_options.xml) {
+		print_formats = new PrintXml(header, varpkg_db, format, stability, eixrc,
+			(*portagesettings)["PORTDIR"]);
+	} else if (rc_options.proto) {
+		print_formats = new PrintProto(header, varpkg_db, format, stability,
+			eixrc->getBool("PROTO_STREAM"));
+	} else if(rc_options.json) {
+		print_formats = new PrintJson(header, varpkg_db, format, stability, eixrc);
+	}
+	if (print_formats != NULLPTR) {
+		print_formats->start();
+	}
+}
+
+bool MatchPrinter::package(Package *pkg) {
+	if(likely(!done)) {
+		stability->set_stability(pkg);
+		if(unlikely(print_formats != NULLPTR)) {
+			print_formats->package(pkg);
+		} else {
+			if(pkg->largest_overlay != 0) {
+				need_overlay_table = true;
+				if(overlay_mode <= mode_list_used) {
+					for(Package::iterator ver(pkg->begin());
+						likely(ver != pkg->end()); ++ver) {
+						ExtendedVersion::Overlay key(ver->overlay_key);
+						if(key > 0) {
+							overlay_used[key - 1] = true;
+						}
+					}
+				}
+			}
+			if(overlay_mode != mode_list_used_renumbered) {
+				if(jobs != NULLPTR) {
+					// The package is deleted after it was printed
+					return print(pkg);
+				}
+				print(pkg);
+			}
+		}
+	}
+	if(delete_packages) {
+		delete pkg;
+	}
+	return done;
+}
+
+bool MatchPrinter::print(Package *pkg) {
+	if(jobs != NULLPTR) {
+		if(likely(!done)) {
+			batch.PUSH_BACK(pkg);
+			if(batch.size() >= batch_size) {
+				print_batch();
+			}
+		}
+		return done;
+	}
+	return counted(format->print(pkg, header, varpkg_db, portagesettings, stability, reached_limit));
+}
+
+bool MatchPrinter::counted(bool printed) {
+	if(printed) {
+		have_printed = true;
+		++count;
+		if(unlikely(reached_limit)) {
+			over_limit = true;
+		} else if(unlikely(count == limit)) {
+			reached_limit = true;
+		}
+		if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
+			return (done = true);
+		}
+	}
+	return false;
+}
+
+void MatchPrinter::print_batch() {
+	PrintJobs::Results results;
+	if(unlikely(!jobs->format_packages(batch, &results, header, varpkg_db, portagesettings, stability, &overlay_used, &need_overlay_table))) {
+		eix::say_error(_("a worker process failed"));
+		std::exit(EXIT_FAILURE);
+	}
+	for(PrintJobs::Packages::size_type i(0); likely(i != batch.size()); ++i) {
+		if(likely(!done)) {
+			const PrintJobs::Result& result(results[i]);
+			if(likely(!reached_limit)) {
+				format->print_result(result.output);
+			}
+			counted(result.printed);
+		}
+		if(delete_packages) {
+			delete batch[i];
+		}
+	}
+	batch.clear();
+}
+
+void MatchPrinter::flush() {
+	if(!batch.empty()) {
+		print_batch();
+	}
+}
+
+void MatchPrinter::finish() {
+	if(unlikely(print_formats != NULLPTR)) {
+		print_formats->finish();
+	}
+}
+
 int run_eix(int argc, char** argv) {
 	// Initialize static classes
 	Eapi::init_static();
-	Category::init_static();
 	ExtendedVersion::init_static();
 	PackageTest::init_static();
 	PortageSettings::init_static();
@@ -738,6 +973,7 @@ int run_eix(int argc, char** argv) {
 	// Honour a STFU
 	if(unlikely(rc_options.be_quiet)) {
 		rc_options.pure_packages = true;
+		OutputSink::flush();
 		if(!freopen(DEV_NULL, "w", stdout)) {
 			eix::say_error(_("cannot redirect to \"%s\"")) % DEV_NULL;
 			return EXIT_FAILURE;
@@ -778,7 +1014,7 @@ int run_eix(int argc, char** argv) {
 
 	bool only_printed;
 
-	if(unlikely(rc_options.xml || rc_options.proto)) {
+	if(unlikely(rc_options.xml || rc_options.proto || rc_options.json)) {
 		rc_options.pure_packages = format->no_color = true;
 		only_printed = false;
 	} else {
@@ -804,6 +1040,42 @@ int run_eix(int argc, char** argv) {
 		return EXIT_SUCCESS;
 	}
 
+	// Print the stored output of the query or store it, if requested
+	QueryCache querycache;
+	bool capture(false);
+	const string& result_cache(eixrc["EIX_RESULT_CACHE"]);
+	if(unlikely(!result_cache.empty()) && likely(!reads_stdin(argreader)) &&
+		querycache.init(result_cache, argc, argv, is_tty, cachefile, &eixrc, &portagesettings)) {
+		int status;
+		if(querycache.serve(&status)) {
+			return status;
+		}
+		capture = querycache.capture();
+	}
+	int status(run_query(&eixrc, &portagesettings, argreader, cachefile, tooltext, is_tty, only_printed));
+	if(unlikely(capture)) {
+		querycache.finish(status);
+	}
+	return status;
+}
+
+/**
+@return true if the query reads the standard input
+**/
+static bool reads_stdin(const ArgumentReader& argreader) {
+	for(ArgumentReader::const_iterator it(argreader.begin());
+		likely(it != argreader.end()); ++it) {
+		int option(**it);
+		if(unlikely((option == '|') || (option == O_PIPE_MASK))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static int run_query(EixRc *rc, PortageSettings *settings, const ArgumentReader& argreader, const string& cachefile, const char *tooltext, bool is_tty, bool only_printed) {
+	EixRc& eixrc(*rc);
+	PortageSettings& portagesettings(*settings);
 	string var_db_pkg(eixrc["EPREFIX_INSTALLED"] + VAR_DB_PKG);
 	VarDbPkg varpkg_db(var_db_pkg, !rc_options.quick, rc_options.care,
 		rc_options.deps_installed,
@@ -811,6 +1083,10 @@ int run_eix(int argc, char** argv) {
 		eixrc.getBool("CARE_RESTRICT_INSTALLED"),
 		eixrc.getBool("USE_BUILD_TIME"));
 	varpkg_db.check_installed_overlays = eixrc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
+	const string& snapshot(eixrc["EIX_INSTALLED_SNAPSHOT"]);
+	if(!snapshot.empty()) {
+		varpkg_db.use_snapshot(snapshot);
+	}
 
 	MaskList<Mask> *marked_list(NULLPTR);
 
@@ -891,9 +1167,42 @@ int run_eix(int argc, char** argv) {
 	MatchTree *matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
 	parse_cli(matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &marked_list, argreader);
 
+	format->set_marked_list(marked_list);
+	if(overlay_mode != mode_list_used_renumbered) {
+		format->set_overlay_translations(NULLPTR);
+	}
+	if(rc_options.xml || rc_options.proto || rc_options.json || rc_options.be_quiet) {
+		overlay_mode = mode_list_none;
+		rc_options.pure_packages = true;
+	}
+	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
+	MatchPrinter printer(&header, &varpkg_db, &portagesettings, &stability, &eixrc,
+		(is_tty ? eixrc.getInteger(limit_var) : 0));
+
+	// Unless the matches must be known in advance (for sorting, for
+	// renumbering overlays, or for testing against the config files),
+	// print each match immediately and do not keep it in memory.
+	bool streaming(likely(!rc_options.test_unused) &&
+		likely(!FuzzyAlgorithm::used()) &&
+		(overlay_mode != mode_list_used_renumbered));
+	printer.delete_packages = streaming;
+	if(likely(!rc_options.xml) && likely(!rc_options.proto) && likely(!rc_options.json)) {
+		unsigned int jobs(eixrc.getInteger("EIX_PRINT_JOBS"));
+		// This also catches -1 which is converted to UINT_MAX
+		if(unlikely(jobs > PrintJobs::max_jobs)) {
+			jobs = PrintJobs::max_jobs;
+		}
+		if(jobs > 1) {
+			printer.set_jobs(jobs);
+		}
+	}
+	PackageList::size_type found(0);
 	PackageList matches;
 	PackageList all_packages; {
 		PackageReader reader(&db, header, &portagesettings);
+		if(likely(!rc_options.test_unused) && matchtree->requires_installed()) {
+			reader.set_installed_filter(&varpkg_db);
+		}
 		bool add_rest(false);
 		while(likely(reader.next())) {
 			if(unlikely(add_rest)) {
@@ -903,10 +1212,18 @@ int run_eix(int argc, char** argv) {
 				if(unlikely(release == NULLPTR)) {
 					break;
 				}
-				matches.PUSH_BACK(release);
+				if(likely(streaming)) {
+					if(found == 0) {
+						printer.start();
+					}
+					printer.package(release);
+				} else {
+					matches.PUSH_BACK(release);
+				}
+				++found;
 				if(unlikely(only_printed &&
 					(rc_options.brief ||
-						(rc_options.brief2 && (matches.size() > 1))))) {
+						(rc_options.brief2 && (found > 1))))) {
 					if(unlikely(rc_options.test_unused)) {
 						add_rest = true;
 					} else {
@@ -940,133 +1257,76 @@ int run_eix(int argc, char** argv) {
 
 	if(unlikely(rc_options.test_unused)) {
 		bool empty(eixrc.getBool("TEST_FOR_EMPTY"));
+		PackageIndex packageindex(all_packages);
 		if(likely(eixrc.getBool("TEST_KEYWORDS"))) {
 			print_unused(eixrc.m_eprefixconf + USER_KEYWORDS_FILE1,
 				eixrc["KEYWORDS_NONEXISTENT"],
-				all_packages);
+				packageindex);
 			print_unused(eixrc.m_eprefixconf + USER_KEYWORDS_FILE2,
 				eixrc["KEYWORDS_NONEXISTENT"],
-				all_packages);
+				packageindex);
 		}
 		if(likely(eixrc.getBool("TEST_MASK"))) {
 			print_unused(eixrc.m_eprefixconf + USER_MASK_FILE,
 				eixrc["MASK_NONEXISTENT"],
-				all_packages);
+				packageindex);
 		}
 		if(likely(eixrc.getBool("TEST_UNMASK"))) {
 			print_unused(eixrc.m_eprefixconf + USER_UNMASK_FILE,
 				eixrc["UNMASK_NONEXISTENT"],
-				all_packages);
+				packageindex);
 		}
 		if(likely(eixrc.getBool("TEST_USE"))) {
 			print_unused(eixrc.m_eprefixconf + USER_USE_FILE,
 				eixrc["USE_NONEXISTENT"],
-				all_packages, empty);
+				packageindex, empty);
 		}
 		if(likely(eixrc.getBool("TEST_ENV"))) {
 			print_unused(eixrc.m_eprefixconf + USER_ENV_FILE,
 				eixrc["ENV_NONEXISTENT"],
-				all_packages, empty);
+				packageindex, empty);
 		}
 		if(likely(eixrc.getBool("TEST_LICENSE"))) {
 			print_unused(eixrc.m_eprefixconf + USER_LICENSE_FILE,
 				eixrc["LICENSE_NONEXISTENT"],
-				all_packages, empty);
+				packageindex, empty);
 		}
 		if(likely(eixrc.getBool("TEST_RESTRICT"))) {
 			print_unused(eixrc.m_eprefixconf + USER_RESTRICT_FILE,
 				eixrc["LICENSE_RESTRICT"],
-				all_packages, empty);
+				packageindex, empty);
 		}
 		if(likely(eixrc.getBool("TEST_CFLAGS"))) {
 			print_unused(eixrc.m_eprefixconf + USER_CFLAGS_FILE,
 				eixrc["CFLAGS_NONEXISTENT"],
-				all_packages, empty);
+				packageindex, empty);
 		}
 		if(likely(eixrc.getBool("TEST_REMOVED"))) {
 			print_removed(var_db_pkg, eixrc["INSTALLED_NONEXISTENT"], all_packages);
 		}
 	}
 
-	/* Sort the found matches by rating */
-	if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
-		std::sort(matches.begin(), matches.end(), FuzzyAlgorithm::compare);
-	}
-
-	format->set_marked_list(marked_list);
-	if(overlay_mode != mode_list_used_renumbered) {
-		format->set_overlay_translations(NULLPTR);
-	}
-	bool need_overlay_table(false);
-	PrintFormat::OverlayUsed overlay_used(header.countOverlays(), false);
-	format->set_overlay_used(&overlay_used, &need_overlay_table);
-	PackageList::size_type count(0);
-	PrintFormats *print_formats(NULLPTR);
-	if(rc_options.xml || rc_options.proto || rc_options.be_quiet) {
-		overlay_mode = mode_list_none;
-		rc_options.pure_packages = true;
-	}
-	if (!matches.empty()) {
-		if(rc_options.xml) {
-			if (unlikely(rc_options.proto)) {
-				eix::say_error(_("--xml and --proto must not be specified simultaneously"));
-				std::exit(EXIT_FAILURE);
-			}
-			print_formats = new PrintXml(&header, &varpkg_db, format, &stability, &eixrc,
-				portagesettings["PORTDIR"]);
-		} else if (rc_options.proto) {
-			print_formats = new PrintProto(&header, &varpkg_db, format, &stability);
-		}
-		if (print_formats != NULLPTR) {
-			print_formats->start();
-		}
-	}
-	bool have_printed(false);
-	bool reached_limit(false), over_limit(false);
-	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
-	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
-	for(PackageList::iterator it(matches.begin());
-		likely(it != matches.end()); ++it) {
-		stability.set_stability(*it);
-
-		if(unlikely(print_formats != NULLPTR)) {
-			print_formats->package(*it);
-			continue;
+	if(!streaming) {
+		/* Sort the found matches by rating */
+		if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
+			std::sort(matches.begin(), matches.end(), FuzzyAlgorithm::compare);
 		}
-
-		if(it->largest_overlay != 0) {
-			need_overlay_table = true;
-			if(overlay_mode <= mode_list_used) {
-				for(Package::iterator ver(it->begin());
-					likely(ver != it->end()); ++ver) {
-					ExtendedVersion::Overlay key(ver->overlay_key);
-					if(key > 0) {
-						overlay_used[key - 1] = true;
-					}
-				}
-			}
+		if(!matches.empty()) {
+			printer.start();
 		}
-		if(overlay_mode != mode_list_used_renumbered) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
-				have_printed = true;
-				++count;
-				if(unlikely(reached_limit)) {
-					over_limit = true;
-				} else if(unlikely(count == limit)) {
-					reached_limit = true;
-				}
-				if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
-					break;
-				}
+		for(PackageList::iterator it(matches.begin());
+			likely(it != matches.end()); ++it) {
+			if(unlikely(printer.package(*it))) {
+				break;
 			}
 		}
 	}
 	switch(overlay_mode) {
 		case mode_list_all:
-			need_overlay_table = true;
+			printer.need_overlay_table = true;
 			break;
 		case mode_list_none:
-			need_overlay_table = false;
+			printer.need_overlay_table = false;
 			break;
 		default:
 			break;
@@ -1074,9 +1334,9 @@ int run_eix(int argc, char** argv) {
 	PrintFormat::OverlayTranslations overlay_num(header.countOverlays(), 0);
 	if(overlay_mode == mode_list_used_renumbered) {
 		ExtendedVersion::Overlay i(1);
-		PrintFormat::OverlayUsed::iterator uit(overlay_used.begin());
+		PrintFormat::OverlayUsed::iterator uit(printer.overlay_used.begin());
 		PrintFormat::OverlayTranslations::iterator nit(overlay_num.begin());
-		for(; likely(uit != overlay_used.end()); ++uit, ++nit) {
+		for(; likely(uit != printer.overlay_used.end()); ++uit, ++nit) {
 			if(*uit == true) {
 				*nit = i++;
 			}
@@ -1084,35 +1344,23 @@ int run_eix(int argc, char** argv) {
 		format->set_overlay_translations(&overlay_num);
 		for(PackageList::iterator it(matches.begin());
 			likely(it != matches.end()); ++it) {
-			if(format->print(*it, &header, &varpkg_db, &portagesettings, &stability, reached_limit)) {
-				have_printed = true;
-				++count;
-				if(unlikely(reached_limit)) {
-					over_limit = true;
-				} else if(unlikely(count == limit)) {
-					reached_limit = true;
-				}
-				if(unlikely(rc_options.brief || (rc_options.brief2 && count > 1))) {
-					break;
-				}
+			if(unlikely(printer.print(*it))) {
+				break;
 			}
 		}
 	}
+	printer.flush();
 	bool printed_overlay(false);
-	if(need_overlay_table) {
+	if(printer.need_overlay_table) {
 		if(print_overlay_table(format, &header,
-			(overlay_mode <= mode_list_used)? &overlay_used : NULLPTR)) {
-			printed_overlay = have_printed = true;
+			(overlay_mode <= mode_list_used)? &printer.overlay_used : NULLPTR)) {
+			printed_overlay = printer.have_printed = true;
 		}
 	}
-	if(unlikely(print_formats != NULLPTR)) {
-		print_formats->finish();
-		delete print_formats;
-	}
+	printer.finish();
 
-	if(!only_printed) {
-		count = matches.size();
-	}
+	PackageList::size_type count(only_printed ? printer.count : found);
+	bool have_printed(printer.have_printed);
 	eix::SignedBool print_count_always(rc_options.pure_packages ? -1 :
 		eixrc.getBoolText("PRINT_COUNT_ALWAYS", "never"));
 	if(likely(print_count_always >= 0)) {
@@ -1137,13 +1385,13 @@ int run_eix(int argc, char** argv) {
 	}
 	if(likely(have_printed)) {
 		eix::print() % format->color_end;
-		if(unlikely(over_limit)) {
+		if(unlikely(printer.over_limit)) {
 			eix::say(N_(
 			"Only %s match displayed on terminal\n"
 			"Set %s=0 to show all matches",
 			"Only %s matches displayed on terminal\n"
-			"Set %s=0 to show all matches", limit))
-				% limit
+			"Set %s=0 to show all matches", printer.limit))
+				% printer.limit
 				% limit_var;
 		}
 	}
@@ -1198,7 +1446,49 @@ static void print_wordvec(const WordVec& vec) {
 	eix::say("--");
 }
 
-static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty) {
+PackageIndex::PackageIndex(const PackageList& list) : packagelist(&list) {
+	for(PackageList::const_iterator pi(list.begin());
+		likely(pi != list.end()); ++pi) {
+		cat_map[pi->category][pi->name] = *pi;
+	}
+}
+
+/**
+fnmatch() without flags treats a pattern without these characters literally
+**/
+inline static bool is_literal(const char *pattern) {
+	return (std::strpbrk(pattern, "*?[\\") == NULLPTR);
+}
+
+bool PackageIndex::have_match(const Mask& m) const {
+	if(unlikely(!is_literal(m.getCategory()))) {
+		for(PackageList::const_iterator pi(packagelist->begin());
+			likely(pi != packagelist->end()); ++pi) {
+			if(m.ismatch(**pi)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	CatMap::const_iterator c(cat_map.find(m.getCategory()));
+	if(c == cat_map.end()) {
+		return false;
+	}
+	const NameMap& names(c->second);
+	if(likely(is_literal(m.getName()))) {
+		NameMap::const_iterator n(names.find(m.getName()));
+		return ((n != names.end()) && m.ismatch(*(n->second)));
+	}
+	for(NameMap::const_iterator n(names.begin());
+		likely(n != names.end()); ++n) {
+		if(m.ismatch(*(n->second))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void print_unused(const string& filename, const string& excludefiles, const PackageIndex& packageindex, bool test_empty) {
 	WordVec unused;
 	LineVec lines;
 	WordSet excludes;
@@ -1245,13 +1535,7 @@ static void print_unused(const string& filename, const string& excludefiles, con
 			parse_error->output(filename, lines.begin(), i, errtext);
 			continue;
 		}
-		PackageList::const_iterator pi(packagelist.begin());
-		for( ; likely(pi != packagelist.end()); ++pi) {
-			if(m.ismatch(**pi)) {
-				break;
-			}
-		}
-		if(pi != packagelist.end()) {
+		if(packageindex.have_match(m)) {
 			continue;
 		}
 		unused.PUSH_BACK(MOVE(*i));
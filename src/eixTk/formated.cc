@@ -11,6 +11,7 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <string>
 #include <vector>
@@ -19,7 +20,9 @@
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -33,16 +36,16 @@ const FormatManip::ArgType
 	FormatManip::DIGIT,
 	FormatManip::BOTH;
 
-void format::bad_format() const {
+void FormatSpec::bad_format() const {
 	eix::say_error(_("internal error: bad format specification \"%s\""))
-		% m_text;
+		% m_original;
 	std::exit(EXIT_FAILURE);
 }
 
 #ifdef EIX_DEBUG_FORMAT
 void format::too_few_arguments() const {
 	eix::say_error(_("internal error: too few arguments passed for \"%s\""))
-		% m_text;
+		% (simple ? m_text : spec().m_original);
 	std::exit(EXIT_FAILURE);
 }
 
@@ -53,34 +56,37 @@ void format::too_many_arguments() const {
 }
 #endif
 
-void format::init() {
-	simple = false;
-	current = 0;
-	FormatManip::ArgCount imp(0);
+void FormatSpec::parse(const char *format_string, string::size_type len) {
+	m_original.assign(format_string, len);
+	m_text.clear();
+	manip.clear();
+	wanted.clear();
+	ArgCount imp(0);
 	string::size_type i(0);
-	while(i = m_text.find('%', i), likely(i != string::npos)) {
-		string::size_type start(i), len(2);
-		++i;
-		if(unlikely(i == m_text.size())) {
+	for(;;) {
+		string::size_type start(m_original.find('%', i));
+		if(likely(start == string::npos)) {
+			m_text.append(m_original, i, string::npos);
+			break;
+		}
+		m_text.append(m_original, i, start - i);
+		i = start + 1;
+		if(unlikely(i == len)) {
 			bad_format();
 		}
-		char c(m_text[i]);
+		char c(m_original[i]);
 		if(c == '%') {
-			m_text.erase(start, len);
-			if(likely(start != m_text.size())) {
-				i = start;
-				continue;
-			}
-			break;
+			m_text.append(1, '%');
+			++i;
+			continue;
 		}
 		ArgCount argnum(imp++);
 		if(my_isdigit(c)) {
-			string::size_type e(m_text.find('$', i));
+			string::size_type e(m_original.find('$', i));
 			if(unlikely(e == string::npos)) {
 				bad_format();
 			}
-			len += e - start;
-			string number(m_text, i, e - i);
+			string number(m_original, i, e - i);
 			if(unlikely(!is_numeric(number.c_str()))) {
 				bad_format();
 			}
@@ -89,12 +95,13 @@ void format::init() {
 				bad_format();
 			}
 			--argnum;
-			++e;
-			if(unlikely(e == m_text.size())) {
+			i = e + 1;
+			if(unlikely(i == len)) {
 				bad_format();
 			}
-			c = m_text[e];
+			c = m_original[i];
 		}
+		++i;
 		ArgType typ;
 #ifdef EIX_DEBUG_FORMAT
 		switch(c) {
@@ -119,28 +126,78 @@ void format::init() {
 		} else {
 			wanted[argnum] |= typ;
 		}
-		manip.EMPLACE_BACK(FormatManip, (start, argnum, typ));
-		m_text.erase(start, len);
-		i = start;
-		if(i == m_text.size()) {
-			break;
+		manip.EMPLACE_BACK(FormatManip, (m_text.size(), argnum, typ));
+	}
+}
+
+const FormatSpec *FormatSpec::cached(const char *format_string, string::size_type len) {
+	typedef UNORDERED_MAP<const char *, FormatSpec> Cache;
+	// Format strings are mostly literals or translations; others
+	// should not let the cache grow arbitrarily
+	static CONSTEXPR const Cache::size_type capacity = 1024;
+	// Never freed: eix::format might be used in destructors of static objects
+	static Cache *cache(NULLPTR);
+	if(unlikely(cache == NULLPTR)) {
+		cache = new Cache;
+	}
+	Cache::const_iterator it(cache->find(format_string));
+	if(likely(it != cache->end())) {
+		const string& original(it->second.m_original);
+		if(likely((original.size() == len) &&
+			(std::memcmp(original.c_str(), format_string, len) == 0))) {
+			return &(it->second);
 		}
+		// A different string at the same address; the entry might be in use
+		return NULLPTR;
+	}
+	if(unlikely(cache->size() >= capacity)) {
+		return NULLPTR;
+	}
+	FormatSpec& spec((*cache)[format_string]);
+	spec.parse(format_string, len);
+	return &spec;
+}
+
+void format::init(const char *format_string) {
+	string::size_type len(std::strlen(format_string));
+	m_spec = FormatSpec::cached(format_string, len);
+	if(unlikely(m_spec == NULLPTR)) {
+		m_parsed.parse(format_string, len);
+	}
+	start();
+}
+
+void format::init(const string& format_string) {
+	m_spec = FormatSpec::cached(format_string.c_str(), format_string.size());
+	if(unlikely(m_spec == NULLPTR)) {
+		m_parsed.parse(format_string.c_str(), format_string.size());
 	}
-	if(unlikely(wanted.empty())) {
-		finalize();
+	start();
+}
+
+void format::start() {
+	simple = false;
+	current = 0;
+	const FormatSpec& sp(spec());
+	if(unlikely(sp.wanted.empty())) {
+		m_text = sp.m_text;
+		newline_output();
 	} else {
-		args.insert(args.end(), wanted.size(), FormatReplace());
+		args.resize(sp.wanted.size());
 	}
 }
 
 void format::finalize() {
-	for(std::vector<FormatManip>::const_reverse_iterator it(manip.rbegin());
-		it != manip.rend(); ++it) {
-		m_text.insert(it->m_index, (it->m_type ?
-			args[it->argnum].s : args[it->argnum].d));
+	const FormatSpec& sp(spec());
+	string::size_type prev(0);
+	for(std::vector<FormatManip>::const_iterator it(sp.manip.begin());
+		likely(it != sp.manip.end()); ++it) {
+		m_text.append(sp.m_text, prev, it->m_index - prev);
+		prev = it->m_index;
+		const FormatReplace& arg(args[it->argnum]);
+		m_text.append(it->m_type ? arg.s : arg.d);
 	}
-	manip.clear();
-	wanted.clear();
+	m_text.append(sp.m_text, prev, string::npos);
 	args.clear();
 	newline_output();
 }
@@ -149,7 +206,14 @@ void format::newline_output() {
 	if(add_newline) {
 		m_text.append(1, '\n');
 	}
-	if(output != NULLPTR) {
+	if(output == stdout) {
+		OutputSink::write(m_text);
+		if(unlikely(do_flush)) {
+			OutputSink::flush();
+		}
+	} else if(output != NULLPTR) {
+		// Keep the order of messages on stdout and stderr
+		OutputSink::flush();
 		if(likely(!m_text.empty())) {
 			std::fwrite(m_text.c_str(), sizeof(char),  m_text.size(), output);
 		}
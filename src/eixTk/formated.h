@@ -90,6 +90,7 @@ Example usage:
 class FormatManip {
 	protected:
 		friend class format;
+		friend class FormatSpec;
 
 		typedef TinyUnsigned ArgType;
 		static CONSTEXPR const ArgType
@@ -116,6 +117,34 @@ class FormatReplace {
 		std::string s, d;
 };
 
+/**
+A parsed format string: The text without specifiers and their positions.
+The results for the format strings used are cached so that each distinct
+string (also a translated one) is parsed only once.
+**/
+class FormatSpec {
+	protected:
+		friend class format;
+		typedef FormatManip::ArgType ArgType;
+		typedef FormatManip::ArgCount ArgCount;
+
+		std::string m_original, m_text;
+		std::vector<FormatManip> manip;
+		std::vector<ArgType> wanted;
+
+		ATTRIBUTE_NORETURN void bad_format() const;
+
+		ATTRIBUTE_NONNULL_ void parse(const char *format_string, std::string::size_type len);
+
+		/**
+		The cache is keyed by the address of the format string; the content
+		is compared nevertheless, since the address might be reused.
+		The cache is not thread-safe.
+		@return the parsed format_string or NULLPTR if it is not cached
+		**/
+		ATTRIBUTE_NONNULL_ static const FormatSpec *cached(const char *format_string, std::string::size_type len);
+};
+
 class format {
 	protected:
 		typedef FormatManip::ArgType ArgType;
@@ -124,39 +153,106 @@ class format {
 		bool add_newline, do_flush;
 		FILE *output;
 		/**
-		The currently parsed args
+		The currently parsed args; empty if the result is complete
 		**/
 		ArgCount current;
 		std::vector<FormatReplace> args;
-		std::vector<ArgType> wanted;
 
 		/**
-		The format string or result
+		The parsed format string: m_spec or, if this is NULLPTR, m_parsed
+		**/
+		const FormatSpec *m_spec;
+		FormatSpec m_parsed;
+
+		/**
+		The result
 		**/
 		std::string m_text;
-		std::vector<FormatManip> manip;
 
-		ATTRIBUTE_NORETURN void bad_format() const;
+		const FormatSpec& spec() const {
+			return ((m_spec == NULLPTR) ? m_parsed : *m_spec);
+		}
+
 #ifdef EIX_DEBUG_FORMAT
 		ATTRIBUTE_NORETURN void too_few_arguments() const;
 		ATTRIBUTE_NORETURN void too_many_arguments() const;
 #endif
 
+		template<typename T> static void append_unsigned(std::string *s, T t) {
+			char buf[3 * sizeof(T) + 1];
+			char *end(buf + sizeof(buf));
+			char *p(end);
+			do {
+				*(--p) = static_cast<char>('0' + (t % 10));
+				t /= 10;
+			} while(t != 0);
+			s->append(p, end - p);
+		}
+
+		/**
+		Append the representation of t by the <<-operator of std::ostream to s.
+		Frequent types are converted directly.
+		**/
+		template<typename T> static void append_value(std::string *s, const T& t) {
+			std::ostringstream os;
+			os << t;
+			s->append(os.str());
+		}
+
+		static void append_value(std::string *s, const std::string& t) {
+			s->append(t);
+		}
+
+		ATTRIBUTE_NONNULL_ static void append_value(std::string *s, const char *t) {
+			s->append(t);
+		}
+
+		static void append_value(std::string *s, char t) {
+			s->append(1, t);
+		}
+
+		static void append_value(std::string *s, unsigned int t) {
+			append_unsigned(s, t);
+		}
+
+		static void append_value(std::string *s, unsigned long t) {  // NOLINT(runtime/int)
+			append_unsigned(s, t);
+		}
+
+		static void append_value(std::string *s, int t) {
+			if(unlikely(t < 0)) {
+				s->append(1, '-');
+				append_unsigned(s, 0U - static_cast<unsigned int>(t));
+				return;
+			}
+			append_unsigned(s, static_cast<unsigned int>(t));
+		}
+
+		static void append_value(std::string *s, long t) {  // NOLINT(runtime/int)
+			if(unlikely(t < 0)) {
+				s->append(1, '-');
+				append_unsigned(s, 0UL - static_cast<unsigned long>(t));  // NOLINT(runtime/int)
+				return;
+			}
+			append_unsigned(s, static_cast<unsigned long>(t));  // NOLINT(runtime/int)
+		}
+
 		/**
-		Write size_type or "<string::npos>" to stream
+		Append size_type or "<string::npos>" to s
 		**/
-		static std::ostream& write_representation(std::ostream& s, const std::string::size_type& t) {  // NOLINT(runtime/references)
+		static void append_digit(std::string *s, const std::string::size_type& t) {
 			if(t == std::string::npos) {
-				return (s << "<string::npos>");
+				s->append("<string::npos>");
+				return;
 			}
-			return (s << t);
+			append_unsigned(s, t);
 		}
 
 		/**
-		Write t into stream s
+		Append t to s
 		**/
-		template<typename T> static std::ostream& write_representation(std::ostream& s, const T& t) {  // NOLINT(runtime/references)
-			return s << t;
+		template<typename T> static void append_digit(std::string *s, const T& t) {
+			append_value(s, t);
 		}
 
 		void finalize();
@@ -166,63 +262,67 @@ class format {
 		/**
 		Set the template string. Set simple = false
 		**/
-		void init();
+		ATTRIBUTE_NONNULL_ void init(const char *format_string);
+
+		void init(const std::string& format_string);
+
+		void start();
 
 	public:
-		format(FILE *stream, const std::string& format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string, bool newline, bool flush) : add_newline(newline), do_flush(flush), output(stream) {
+			init(format_string);
 		}
 
 		format(FILE *stream, char format_char, bool newline, bool flush) : simple(false), add_newline(newline), do_flush(flush), output(stream), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(FILE *stream, const std::string& format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string, bool newline) : add_newline(newline), do_flush(false), output(stream) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string, bool newline) : add_newline(newline), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string, bool newline) : add_newline(newline), do_flush(false), output(stream) {
+			init(format_string);
 		}
 
 		format(FILE *stream, char format_char, bool newline) : simple(false), add_newline(newline), do_flush(false), output(stream), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(FILE *stream, const std::string& format_string) : add_newline(false), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const std::string& format_string) : add_newline(false), do_flush(false), output(stream) {
+			init(format_string);
 		}
 
-		format(FILE *stream, const char *format_string) : add_newline(false), do_flush(false), output(stream), m_text(format_string) {
-			init();
+		format(FILE *stream, const char *format_string) : add_newline(false), do_flush(false), output(stream) {
+			init(format_string);
 		}
 
 		format(FILE *stream, char format_char) : simple(false), add_newline(false), do_flush(false), output(stream), m_text(1, format_char) {
 			newline_output();
 		}
 
-		format(const std::string& format_string, bool newline) : add_newline(newline), output(NULLPTR), m_text(format_string) {
-			init();
+		format(const std::string& format_string, bool newline) : add_newline(newline), output(NULLPTR) {
+			init(format_string);
 		}
 
-		format(const char *format_string, bool newline) : add_newline(newline), output(NULLPTR), m_text(format_string) {
-			init();
+		format(const char *format_string, bool newline) : add_newline(newline), output(NULLPTR) {
+			init(format_string);
 		}
 
 		format(char format_char, bool newline) : simple(false), add_newline(newline), output(NULLPTR), m_text(1, format_char) {
 			newline_output();
 		}
 
-		explicit format(const std::string& format_string) : add_newline(false), output(NULLPTR), m_text(format_string) {
-			init();
+		explicit format(const std::string& format_string) : add_newline(false), output(NULLPTR) {
+			init(format_string);
 		}
 
-		explicit format(const char *format_string) : add_newline(false), output(NULLPTR), m_text(format_string) {
-			init();
+		explicit format(const char *format_string) : add_newline(false), output(NULLPTR) {
+			init(format_string);
 		}
 
 		explicit format(char format_char) : simple(false), add_newline(false), output(NULLPTR), m_text(1, format_char) {
@@ -259,31 +359,25 @@ class format {
 		template<typename T> format& operator%(const T& s) {
 			if(simple) {
 				simple = false;
-				std::ostringstream os;
-				os << s;
-				m_text.append(os.str());
+				append_value(&m_text, s);
 				newline_output();
 				return *this;
 			}
-			if(unlikely(manip.empty())) {
+			if(unlikely(args.empty())) {
 #ifdef EIX_DEBUG_FORMAT
 				too_many_arguments();
 #else
 				return *this;
 #endif
 			}
-			ArgType c(wanted[current]);
+			ArgType c(spec().wanted[current]);
 			if((c & FormatManip::STRING) != FormatManip::NONE) {
-				std::ostringstream os;
-				os << s;
-				args[current].s = os.str();
+				append_value(&(args[current].s), s);
 			}
 			if((c & FormatManip::DIGIT) != FormatManip::NONE) {
-				std::ostringstream os;
-				write_representation(os, s);
-				args[current].d = os.str();
+				append_digit(&(args[current].d), s);
 			}
-			if(unlikely(++current == wanted.size())) {
+			if(unlikely(++current == args.size())) {
 				finalize();
 			}
 			return *this;
@@ -294,7 +388,7 @@ class format {
 		**/
 		std::string str() const {
 #ifdef EIX_DEBUG_FORMAT
-			if(unlikely(simple || !manip.empty())) {
+			if(unlikely(simple || !args.empty())) {
 				too_few_arguments();
 			}
 #endif
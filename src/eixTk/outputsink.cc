@@ -0,0 +1,68 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "eixTk/outputsink.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+
+using std::string;
+
+string *OutputSink::m_buffer = NULLPTR;
+bool OutputSink::m_line_buffered = false;
+
+static void flush_at_exit() {
+	OutputSink::flush();
+}
+
+void OutputSink::init() {
+	m_buffer = new string;
+	m_buffer->reserve(capacity + 4096);
+	m_line_buffered = (isatty(fileno(stdout)) != 0);
+	std::atexit(flush_at_exit);
+}
+
+void OutputSink::written_slow() {
+	if(m_line_buffered && (m_buffer->find('\n') == string::npos) &&
+		(m_buffer->size() < capacity)) {
+		return;
+	}
+	flush();
+}
+
+void OutputSink::flush() {
+	if(m_buffer == NULLPTR) {
+		std::fflush(stdout);
+		return;
+	}
+	// Data passed to stdio before must come first
+	std::fflush(stdout);
+	int fd(fileno(stdout));
+	const char *s(m_buffer->c_str());
+	string::size_type len(m_buffer->size());
+	while(len != 0) {
+		ssize_t w(::write(fd, s, len));
+		if(unlikely(w < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		s += w;
+		len -= w;
+	}
+	m_buffer->clear();
+}
@@ -0,0 +1,76 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_EIXTK_OUTPUTSINK_H_
+#define SRC_EIXTK_OUTPUTSINK_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+
+/**
+Buffer for everything written to stdout.
+The buffer is written with a single write(2) whenever it is full.
+If stdout is a terminal, it is written at the end of each line like stdio
+does. Everybody who writes to stdout without this class must call flush()
+before.
+**/
+class OutputSink {
+	private:
+		static std::string *m_buffer;
+		static bool m_line_buffered;
+
+		static void init();
+
+		static void written_slow();
+
+	public:
+		/**
+		Write buffer once it reaches this size
+		**/
+		static const std::string::size_type capacity = 64 * 1024;
+
+		/**
+		@return the buffer; call written() after appending to it
+		**/
+		static std::string *buffer() {
+			if(unlikely(m_buffer == NULLPTR)) {
+				init();
+			}
+			return m_buffer;
+		}
+
+		/**
+		Write the buffer if necessary
+		**/
+		static void written() {
+			if(unlikely(m_line_buffered || (m_buffer->size() >= capacity))) {
+				written_slow();
+			}
+		}
+
+		ATTRIBUTE_NONNULL_ static void write(const char *s, std::string::size_type len) {
+			buffer()->append(s, len);
+			written();
+		}
+
+		static void write(const std::string& s) {
+			buffer()->append(s);
+			written();
+		}
+
+		/**
+		Write the buffer and the stdio buffer of stdout
+		**/
+		static void flush();
+};
+
+#endif  // SRC_EIXTK_OUTPUTSINK_H_
@@ -14,9 +14,9 @@
 
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
-#include "eixTk/formated.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 
@@ -220,19 +220,21 @@ void OutputString::append(const OutputString& a) {
 	if(a.empty()) {
 		return;
 	}
+	if(absolute) {
+		a.print(&m_string, &m_size);
+		return;
+	}
+	// The columns in a before its first newline are still relative
+	for(InsertType::const_iterator it(a.m_insert.begin());
+		unlikely(it != a.m_insert.end()); ++it) {
+		m_insert.PUSH_BACK((*it) + m_string.size());
+		m_insert.PUSH_BACK((*(++it)) + m_size);
+		m_insert.PUSH_BACK(*(++it));
+	}
 	if(a.absolute) {
 		absolute = true;
 		m_size = a.m_size;
-	} else if(absolute) {
-		a.print(&m_string, &m_size);
-		return;
 	} else {
-		for(InsertType::const_iterator it(a.m_insert.begin());
-			unlikely(it != a.m_insert.end()); ++it) {
-			m_insert.PUSH_BACK((*it) + m_string.size());
-			m_insert.PUSH_BACK((*(++it)) + m_size);
-			m_insert.PUSH_BACK(*(++it));
-		}
 		m_size += a.m_size;
 	}
 	m_string.append(a.m_string);
@@ -245,13 +247,16 @@ void OutputString::print(std::string *dest, WordSize *s) const {
 	} else {
 		WordSize r(0);
 		WordSize curr(*s);
+		WordSize size(0);
 		for(InsertType::const_iterator it(m_insert.begin());
 			unlikely(it != m_insert.end()); ++it) {
 			if(*it > r) {
 				dest->append(m_string, r, (*it) - r);
 				r = *it;
 			}
-			curr += *(++it);
+			// The stored size is counted from the beginning of the string
+			curr += *(++it) - size;
+			size = *it;
 			WordSize aim(*(++it));
 			WordSize d;
 			if(aim  == 0) {  // tab
@@ -275,7 +280,56 @@ void OutputString::print(std::string *dest, WordSize *s) const {
 }
 
 void OutputString::print(WordSize *s) const {
-	string d;
-	print(&d, s);
-	eix::print() % d;
+	print(OutputSink::buffer(), s);
+	OutputSink::written();
+}
+
+static void serialize_num(string *dest, WordSize n) {
+	dest->append(reinterpret_cast<const char *>(&n), sizeof(n));
+}
+
+static bool unserialize_num(WordSize *n, const char **pos, const char *end) {
+	if(unlikely(static_cast<WordSize>(end - *pos) < sizeof(*n))) {
+		return false;
+	}
+	std::memcpy(n, *pos, sizeof(*n));
+	*pos += sizeof(*n);
+	return true;
+}
+
+void OutputString::serialize(string *dest) const {
+	serialize_num(dest, m_string.size());
+	dest->append(m_string);
+	serialize_num(dest, m_size);
+	serialize_num(dest, (absolute ? 1 : 0));
+	serialize_num(dest, m_insert.size());
+	for(InsertType::const_iterator it(m_insert.begin());
+		unlikely(it != m_insert.end()); ++it) {
+		serialize_num(dest, *it);
+	}
+}
+
+bool OutputString::unserialize(const char **pos, const char *end) {
+	WordSize len, abs, count;
+	if(unlikely(!unserialize_num(&len, pos, end)) ||
+		unlikely(static_cast<WordSize>(end - *pos) < len)) {
+		return false;
+	}
+	m_string.assign(*pos, len);
+	*pos += len;
+	if(unlikely(!unserialize_num(&m_size, pos, end)) ||
+		unlikely(!unserialize_num(&abs, pos, end)) ||
+		unlikely(!unserialize_num(&count, pos, end)) ||
+		unlikely(static_cast<WordSize>(end - *pos) / sizeof(WordSize) < count)) {
+		return false;
+	}
+	absolute = (abs != 0);
+	m_insert.resize(count);
+	for(InsertType::iterator it(m_insert.begin());
+		unlikely(it != m_insert.end()); ++it) {
+		if(unlikely(!unserialize_num(&(*it), pos, end))) {
+			return false;
+		}
+	}
+	return true;
 }
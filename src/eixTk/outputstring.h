@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/formated.h"
 #include "eixTk/stringtypes.h"
 
@@ -45,7 +46,7 @@ class OutputString {
 		}
 
 	public:
-		OutputString() : m_size(0), absolute(false) {
+		OutputString() NOEXCEPT : m_size(0), absolute(false) {
 		}
 
 		explicit OutputString(const std::string& t) : m_string(t) {
@@ -131,6 +132,18 @@ class OutputString {
 		void append(const OutputString& a);
 		ATTRIBUTE_NONNULL_ void print(std::string *dest, WordSize *s) const;
 		ATTRIBUTE_NONNULL_ void print(WordSize *s) const;
+
+		/**
+		Append a binary representation for unserialize() in a process
+		of the same binary
+		**/
+		ATTRIBUTE_NONNULL_ void serialize(std::string *dest) const;
+
+		/**
+		Read the representation of serialize() starting at *pos
+		@return false if the data ends before end
+		**/
+		ATTRIBUTE_NONNULL_ bool unserialize(const char **pos, const char *end);
 };
 
 inline static std::ostream& operator<<(std::ostream& os, const OutputString& str) {
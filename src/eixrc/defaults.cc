@@ -174,6 +174,27 @@ AddOption(STRING, "EIX_CACHEFILE",
 	"%{EPREFIX}" EIX_CACHEFILE, P_("EIX_CACHEFILE",
 	"This file is the default eix cache."));
 
+AddOption(STRING, "EIX_RESULT_CACHE",
+	"", P_("EIX_RESULT_CACHE",
+	"If this is nonempty, eix stores the output of queries in this directory\n"
+	"and prints the stored output if the same query is repeated while the\n"
+	"eix cache, the configuration, the profile, and the installed packages\n"
+	"are unchanged. Changes in the repositories are only noticed through the\n"
+	"eix cache, i.e. eix-update must be run after syncing, as usual.\n"
+	"Messages to stderr are not repeated for stored results."));
+
+AddOption(STRING, "EIX_INSTALLED_SNAPSHOT",
+	"", P_("EIX_INSTALLED_SNAPSHOT",
+	"If this is nonempty, eix keeps a copy of the data it reads from the\n"
+	"installed package database in this file. A category is read again\n"
+	"from the database only if its directory has changed."));
+
+AddOption(STRING, "EIX_PROFILE_CACHE",
+	"", P_("EIX_PROFILE_CACHE",
+	"If this is nonempty, eix stores the result of reading the profile in\n"
+	"this file. The profile is read again only if a file of the profile or\n"
+	"a relevant setting has changed."));
+
 AddOption(STRING, "EIX_PREVIOUS",
 	"%{EPREFIX}" EIX_PREVIOUS, P_("EIX_PREVIOUS",
 	"This file is the previous eix cache (used by eix-diff and eix-sync)."));
@@ -283,6 +304,11 @@ AddOption(INTEGER, "EIX_LIMIT_COMPACT",
 	"The maximal number of matches shown on terminal in compact mode.\n"
 	"The value 0 means all matches are shown."));
 
+AddOption(INTEGER, "EIX_PRINT_JOBS",
+	"0", P_("EIX_PRINT_JOBS",
+	"If this is larger than 1, matches are formatted by this number of\n"
+	"worker processes (at most 32). The output order is not changed."));
+
 AddOption(BOOLEAN, "QUICKMODE",
 	"false", P_("QUICKMODE",
 	"Whether --quick is on by default."));
@@ -319,6 +345,11 @@ AddOption(BOOLEAN, "DIFF_SEPARATE_DELETED",
 	"true", P_("DIFF_SEPARATE_DELETED",
 	"If false, eix-diff will mix deleted and changed packages"));
 
+AddOption(BOOLEAN, "DIFF_CHECKSUMS",
+	"true", P_("DIFF_CHECKSUMS",
+	"If true, eix-diff does not read packages whose checksums in the\n"
+	"databases agree but considers them as unchanged."));
+
 AddOption(BOOLEAN, "NO_RESTRICTIONS",
 	"false", P_("NO_RESTRICTIONS",
 	"This variable is only used for delayed substitution.\n"
@@ -3392,18 +3423,23 @@ AddOption(STRING, "FORMAT_SHORT_INSTALLATION_DATE",
 AddOption(STRING, "XML_KEYWORDS",
 	"none", P_("XML_KEYWORDS",
 	"Can be full/effective/both/full*/effective*/none.\n"
-	"Depending on the value, with --xml the full/effective (or both types)\n"
+	"Depending on the value, with --xml or --json the full/effective (or both types)\n"
 	"KEYWORDS string is output for each version.\n"
 	"With full*/effective* also both types are output if they differ."));
 
 AddOption(STRING, "XML_OVERLAY",
 	"false", P_("XML_OVERLAY",
-	"If false, the overlay is not output with --xml.\n"
+	"If false, the overlay is not output with --xml or --json.\n"
 	"For overlays without label (repository name) the overlay is output anyway."));
 
 AddOption(STRING, "XML_DATE",
 	"%s", P_("XML_DATE",
-	"strftime() format for printing the installation date with --xml."));
+	"strftime() format for printing the installation date with --xml or --json."));
+
+AddOption(BOOLEAN, "PROTO_STREAM",
+	"false", P_("PROTO_STREAM",
+	"If true, --proto outputs a length-delimited message for each match\n"
+	"instead of a single collection at the end."));
 
 AddOption(STRING, "FORMAT_MASKREASONS_LINESKIP",
 	"%{?WIDETERM}"
@@ -147,6 +147,16 @@ const char *EixRc::cstr(const string& key) const {
 	return (s->second).c_str();
 }
 
+void EixRc::append_config(string *s) const {
+	for(WordIterateMap::const_iterator it(filevarmap.begin());
+		likely(it != filevarmap.end()); ++it) {
+		s->append(it->first);
+		s->append(1, '=');
+		s->append(it->second);
+		s->append(1, '\0');
+	}
+}
+
 const char *EixRc::prefix_cstr(const string& key) const {
 	const char *s(cstr(key));
 	if(unlikely(s == NULLPTR)) {
@@ -88,6 +88,12 @@ class EixRc {
 
 		ATTRIBUTE_PURE const char *prefix_cstr(const std::string& key) const;
 
+		/**
+		Append all variables from the config files and the environment
+		to *s; this identifies the configuration which is in effect
+		**/
+		ATTRIBUTE_NONNULL_ void append_config(std::string *s) const;
+
 		void known_vars();
 		bool print_var(const std::string& key);
 
@@ -44,8 +44,6 @@ using std::map;
 using std::pair;
 using std::string;
 
-ATTRIBUTE_NONNULL_ static Package *old_or_new(string *new_name, Package *older, Package *newer, const string& name);
-
 class VersionVariables {
 	private:
 		const Version *m_version;
@@ -87,7 +85,7 @@ PrintFormat::iuse_expand(OutputString *s, const IUseSet& iuse, bool coll, Handle
 	}
 	typedef map<string, OutputString> ExpVars;
 	ExpVars expvars;
-	const IUseSet::IUseStd& iuse_std(iuse.asStd());
+	const IUseSet::IUseStd iuse_std(iuse.asSorted());
 	for(IUseSet::IUseStd::const_iterator it(iuse_std.begin());
 		it != iuse_std.end(); ++it) {
 		string var, expval;
@@ -560,31 +558,67 @@ class Scanner {
 		}
 };
 
+/**
+A property name resolved by the Scanner
+**/
+class PropertyHandler {
+	public:
+		string name;
+		Scanner::Prop prop;
+		Scanner::Plain plain;
+		Scanner::ColonVar colon_var;
+		Scanner::ColonOther colon_other;
+		string after_colon;
+
+		// Only used by eix-diff:
+		bool diff_context;
+		Scanner::Diff diff;
+		bool older;
+		const PropertyHandler *package_handler;
+
+		PropertyHandler() : prop(Scanner::PKG), plain(NULLPTR), colon_var(NULLPTR), colon_other(NULLPTR), diff_context(false), diff(Scanner::DIFF_NONE), older(false), package_handler(NULLPTR) {
+		}
+};
+
+typedef UNORDERED_MAP<string, PropertyHandler> PropertyHandlers;
+
 static Scanner *scanner = NULLPTR;
 
+/**
+The handlers are shared by all nodes with the same name
+**/
+static PropertyHandlers *package_handlers = NULLPTR;
+static PropertyHandlers *diff_handlers = NULLPTR;
+
 void PrintFormat::init_static() {
 	eix_assert_static(scanner == NULLPTR);
 	scanner = new Scanner;
+	package_handlers = new PropertyHandlers;
+	diff_handlers = new PropertyHandlers;
 	AnsiColor::init_static();
 }
 
-void PrintFormat::get_pkg_property(OutputString *s, Package *package, const string& name) const {
+/**
+@return the handler of the package property name; exit if name is unknown
+**/
+static const PropertyHandler *get_package_handler(const string& name) {
 	eix_assert_static(scanner != NULLPTR);
-	Scanner::Prop t;
-	Scanner::Plain plain(scanner->get_plain(name, &t));
-	// Unnecessary initializations, but silence warning of stupid compiler:
-	Scanner::ColonVar colon_var(NULLPTR);
-	Scanner::ColonOther colon_other(NULLPTR);
-	string after_colon;
-	if(plain == NULLPTR) {
+	PropertyHandlers::const_iterator it(package_handlers->find(name));
+	if(likely(it != package_handlers->end())) {
+		return &(it->second);
+	}
+	PropertyHandler handler;
+	handler.name = name;
+	handler.plain = scanner->get_plain(name, &(handler.prop));
+	if(handler.plain == NULLPTR) {
 		string::size_type col(name.find(':'));
 		if(likely(col != string::npos)) {
 			// we misuse here "after_colon" to mean "before_colon"
-			after_colon.assign(name.substr(0, col));
-			colon_var = scanner->get_colon_var(after_colon, &t);
-			if(unlikely(colon_var == NULLPTR)) {
-				colon_other = scanner->get_colon_other(after_colon, &t);
-				if(unlikely(colon_other == NULLPTR)) {
+			handler.after_colon.assign(name.substr(0, col));
+			handler.colon_var = scanner->get_colon_var(handler.after_colon, &(handler.prop));
+			if(unlikely(handler.colon_var == NULLPTR)) {
+				handler.colon_other = scanner->get_colon_other(handler.after_colon, &(handler.prop));
+				if(unlikely(handler.colon_other == NULLPTR)) {
 					// flag that we failed
 					col = string::npos;
 				}
@@ -594,18 +628,52 @@ void PrintFormat::get_pkg_property(OutputString *s, Package *package, const stri
 			eix::say_error(_("unknown property \"%s\"")) % name;
 			std::exit(EXIT_FAILURE);
 		}
-		after_colon.assign(name, col + 1, string::npos);
+		handler.after_colon.assign(name, col + 1, string::npos);
+	}
+	PropertyHandler& h((*package_handlers)[name]);
+	h = handler;
+	return &h;
+}
+
+/**
+@return the handler of the eix-diff property name
+**/
+static const PropertyHandler *get_diff_handler(const string& name) {
+	eix_assert_static(scanner != NULLPTR);
+	PropertyHandlers::const_iterator it(diff_handlers->find(name));
+	if(likely(it != diff_handlers->end())) {
+		return &(it->second);
+	}
+	PropertyHandler handler;
+	handler.name = name;
+	handler.diff_context = true;
+	handler.diff = scanner->get_diff(name);
+	if(likely(handler.diff == Scanner::DIFF_NONE)) {
+		const char *s(name.c_str());
+		if(std::strncmp(s, "old", 3) == 0) {
+			handler.older = true;
+			s += 3;
+		} else if(std::strncmp(s, "new", 3) == 0) {
+			s += 3;
+		}
+		handler.package_handler = get_package_handler(s);
 	}
-	if(unlikely((t == Scanner::VER) && (version_variables == NULLPTR))) {
-		eix::say_error(_("property \"%s\" used outside version context")) % name;
+	PropertyHandler& h((*diff_handlers)[name]);
+	h = handler;
+	return &h;
+}
+
+void PrintFormat::get_pkg_property(OutputString *s, Package *package, const PropertyHandler& handler) const {
+	if(unlikely((handler.prop == Scanner::VER) && (version_variables == NULLPTR))) {
+		eix::say_error(_("property \"%s\" used outside version context")) % handler.name;
 		std::exit(EXIT_FAILURE);
 	}
-	if(plain != NULLPTR) {
-		(this->*plain)(s, package);
+	if(handler.plain != NULLPTR) {
+		(this->*(handler.plain))(s, package);
 		return;
 	}
-	if(colon_var == NULLPTR) {
-		(this->*colon_other)(s, package, after_colon);
+	if(handler.colon_var == NULLPTR) {
+		(this->*(handler.colon_other))(s, package, handler.after_colon);
 		return;
 	}
 	// colon_var:
@@ -615,7 +683,7 @@ void PrintFormat::get_pkg_property(OutputString *s, Package *package, const stri
 	VersionVariables variables;
 	VersionVariables *previous_variables(version_variables);
 	version_variables = &variables;
-	(this->*colon_var)(package, after_colon);
+	(this->*(handler.colon_var))(package, handler.after_colon);
 	version_variables = previous_variables;
 	s->assign(variables.result);
 }
@@ -855,10 +923,12 @@ void PrintFormat::PKG_WORLD_SETS(OutputString *s, Package *package) const {
 }
 
 void PrintFormat::PKG_SETNAMES(OutputString *s, Package *package) const {
+	package->finalize_local();
 	s->assign_smart(portagesettings->get_setnames(package));
 }
 
 void PrintFormat::PKG_ALLSETNAMES(OutputString *s, Package *package) const {
+	package->finalize_local();
 	s->assign_smart(portagesettings->get_setnames(package, true));
 }
 
@@ -1756,28 +1826,22 @@ void PrintFormat::VER_MASKREASONSS(OutputString *s, Package * /* package */) con
 	ver_maskreasons(s, maskreasonss_skip, maskreasonss_sep);
 }
 
-static Package *old_or_new(string *new_name, Package *older, Package *newer, const string& name) {
-	const char *s(name.c_str());
-	if(std::strncmp(s, "old", 3) == 0) {
-		*new_name = s + 3;
-		return older;
+void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const Property& property) {
+	const PropertyHandler *handler(property.handler);
+	if(unlikely((handler == NULLPTR) || handler->diff_context)) {
+		property.handler = handler = get_package_handler(property.name);
 	}
-	if(std::strncmp(s, "new", 3) == 0) {
-		*new_name = s + 3;
-		return newer;
-	}
-	*new_name = name;
-	return newer;
-}
-
-void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const string& name) {
-	fmt->get_pkg_property(s, static_cast<Package *>(entity), name);
+	fmt->get_pkg_property(s, static_cast<Package *>(entity), *handler);
 }
 
-void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const string& name) {
+void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const Property& property) {
+	const PropertyHandler *handler(property.handler);
+	if(unlikely((handler == NULLPTR) || !handler->diff_context)) {
+		property.handler = handler = get_diff_handler(property.name);
+	}
 	Package *older((static_cast<Package**>(entity))[0]);
 	Package *newer((static_cast<Package**>(entity))[1]);
-	Scanner::Diff diff(scanner->get_diff(name));
+	Scanner::Diff diff(handler->diff);
 	if(unlikely(diff != Scanner::DIFF_NONE)) {
 		LocalCopy copynewer(fmt, newer);
 		LocalCopy copyolder(fmt, older);
@@ -1810,7 +1874,5 @@ void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *en
 		}
 		return;
 	}
-	string new_name;
-	Package *package(old_or_new(&new_name, older, newer, name));
-	fmt->get_pkg_property(s, package, new_name);
+	fmt->get_pkg_property(s, (handler->older ? older : newer), *(handler->package_handler));
 }
@@ -12,14 +12,13 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <string>
-
 #include "eixTk/attribute.h"
 
 class PrintFormat;
 class OutputString;
+class Property;
 
-ATTRIBUTE_NONNULL_ void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const std::string& name);
-ATTRIBUTE_NONNULL_ void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const std::string& name);
+ATTRIBUTE_NONNULL_ void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const Property& property);
+ATTRIBUTE_NONNULL_ void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const Property& property);
 
 #endif  // SRC_OUTPUT_FORMATSTRING_PRINT_H_
@@ -15,6 +15,7 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <deque>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,7 @@
 #include "eixTk/regexp.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 #include "eixrc/eixrc.h"
 #include "portage/extendedversion.h"
 
@@ -62,6 +64,32 @@ LocalCopy::LocalCopy(const PrintFormat *fmt, Package *pkg) :
 	fmt->StabilityNonlocal(pkg);
 }
 
+typedef UNORDERED_MAP<string, Property::Slot> UserVariableSlots;
+
+/**
+The names of user variables are shared by all formats:
+Nodes are shared by copies of PrintFormat
+**/
+static UserVariableSlots& user_variable_slots() {
+	static UserVariableSlots slots;
+	return slots;
+}
+
+Property::Slot Property::get_slot(const string& n) {
+	UserVariableSlots& slots(user_variable_slots());
+	UserVariableSlots::const_iterator it(slots.find(n));
+	if(it != slots.end()) {
+		return it->second;
+	}
+	Slot s(slots.size());
+	slots[n] = s;
+	return s;
+}
+
+Property::Slot Property::slots() {
+	return user_variable_slots().size();
+}
+
 bool VarParserCacheNode::init(const char *fmt, bool colors, bool use, string *errtext) {
 	in_use = use;
 	FormatParser parser;
@@ -360,12 +388,12 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 			case Node::OUTPUT: {
 					Property *p(static_cast<Property*>(root));
 					if(p->user_variable) {
-						if(printString(result, user_variables[p->name])) {
+						if(printString(result, user_variable(*p))) {
 							printed = true;
 						}
 					} else {
 						OutputString s;
-						get_property(&s, this, entity, p->name);
+						get_property(&s, this, entity, *p);
 						if(printString(result, s)) {
 							printed = true;
 						}
@@ -380,11 +408,11 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 					OutputString *rhs;
 					switch(ief->rhs) {
 						case ConditionBlock::RHS_VAR:
-							rhs = &(user_variables[ief->text.text.as_string()]);
+							rhs = &user_variable(ief->rhs_variable);
 							break;
 						case ConditionBlock::RHS_PROPERTY:
 							rhs = &rhsvalue;
-							get_property(rhs, this, entity, ief->text.text.as_string());
+							get_property(rhs, this, entity, ief->rhs_variable);
 							break;
 						default:
 						// case ConditionBlock::RHS_STRING:
@@ -392,7 +420,7 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 							break;
 					}
 					if(root->type == Node::SET) {
-						OutputString& r(user_variables[ief->variable.name]);
+						OutputString& r(user_variable(ief->variable));
 						if(ief->negation) {
 							if(rhs->empty()) {
 								r.set_one();
@@ -407,10 +435,10 @@ bool PrintFormat::recPrint(OutputString *result, void *entity, GetProperty get_p
 					// Node::IF:
 					bool ok;
 					if(ief->user_variable) {
-						ok = rhs->is_equal(user_variables[ief->variable.name]);
+						ok = rhs->is_equal(user_variable(ief->variable));
 					} else {
 						OutputString r;
-						get_property(&r, this, entity, ief->variable.name);
+						get_property(&r, this, entity, ief->variable);
 						ok = rhs->is_equal(r);
 					}
 					if(ief->negation) {
@@ -612,7 +640,7 @@ FormatParser::ParserState FormatParser::state_IF() {
 		last_error = _("'{' without closing '}'");
 		return ERROR;
 	}
-	n->variable = Property(string(name_start, i));
+	n->variable = Property(string(name_start, i), n->user_variable);
 
 	band_position = seek_character(band_position);
 	if(*band_position == '}') {
@@ -706,6 +734,9 @@ GCC_DIAG_ON(sign-conversion)
 		}
 	}
 	n->text = Text(textbuffer);
+	if(n->rhs != ConditionBlock::RHS_STRING) {
+		n->rhs_variable = Property(textbuffer.as_string(), (n->rhs == ConditionBlock::RHS_VAR));
+	}
 
 	if(*band_position != '}') {
 		if(*band_position) {
@@ -834,7 +865,7 @@ bool FormatParser::start(const char *fmt, bool colors, bool parse_only_colors, s
 }
 
 /* return true if something was actually printed */
-bool PrintFormat::print(void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s, bool check_only) {
+bool PrintFormat::print(OutputString *result, void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s) {
 	// The four hackish variables
 	header = dbheader;
 	vardb = vardbpkg;
@@ -843,14 +874,11 @@ bool PrintFormat::print(void *entity, GetProperty get_property, Node *root, cons
 	version_variables = NULLPTR;
 
 	varcache.clear_use();
-	user_variables.clear();
-	bool r;
-	if(unlikely(check_only)) {
-		OutputString dummy;
-		r = recPrint(&dummy, entity, get_property, root);
-	} else {
-		r = recPrint(NULLPTR, entity, get_property, root);
+	for(std::deque<OutputString>::iterator it(user_variables.begin());
+		likely(it != user_variables.end()); ++it) {
+		it->clear();
 	}
+	bool r(recPrint(result, entity, get_property, root));
 	// Reset the four hackish variables
 	header = NULLPTR;
 	vardb = NULLPTR;
@@ -14,6 +14,7 @@
 
 #include <sys/types.h>
 
+#include <deque>
 #include <stack>
 #include <string>
 #include <vector>
@@ -21,6 +22,7 @@
 #include "database/header.h"
 #include "eixTk/assert.h"
 #include "eixTk/attribute.h"
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/outputstring.h"
 #include "eixTk/unordered_map.h"
@@ -70,19 +72,44 @@ class Text : public Node {
 		}
 };
 
+class PropertyHandler;
+
 class Property : public Node {
 	public:
+		typedef std::deque<OutputString>::size_type Slot;
+
 		std::string name;
 		bool user_variable;
 
-		Property() : Node(OUTPUT), user_variable(false) {
+		/**
+		The slot of a user variable is determined when parsing
+		**/
+		Slot slot;
+
+		/**
+		The handler of a property is resolved on first use and then
+		kept so that printing needs no lookup by name
+		**/
+		mutable const PropertyHandler *handler;
+
+		Property() : Node(OUTPUT), user_variable(false), slot(0), handler(NULLPTR) {
 		}
 
-		explicit Property(const std::string& n) : Node(OUTPUT), name(n), user_variable(false) {
+		explicit Property(const std::string& n) : Node(OUTPUT), name(n), user_variable(false), slot(0), handler(NULLPTR) {
 		}
 
-		Property(const std::string& n, bool user_var) : Node(OUTPUT), name(n), user_variable(user_var) {
+		Property(const std::string& n, bool user_var) : Node(OUTPUT), name(n), user_variable(user_var), slot(user_var ? get_slot(n) : 0), handler(NULLPTR) {
 		}
+
+		/**
+		@return the slot of the user variable n, creating it if necessary
+		**/
+		static Slot get_slot(const std::string& n);
+
+		/**
+		@return the number of user variables known so far
+		**/
+		static Slot slots();
 };
 
 class ConditionBlock : public Node {
@@ -91,6 +118,7 @@ class ConditionBlock : public Node {
 
 		Property variable;
 		Text     text;
+		Property rhs_variable;  ///< the property or user variable of the rhs
 		enum Rhs { RHS_STRING, RHS_PROPERTY, RHS_VAR } rhs;
 		Node     *if_true, *if_false;
 		bool user_variable, negation;
@@ -187,11 +215,11 @@ class VersionVariables;
 class PrintFormat {
 	friend class LocalCopy;
 	friend class Scanner;
-	ATTRIBUTE_NONNULL_ friend void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const std::string& name);
-	ATTRIBUTE_NONNULL_ friend void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const std::string& name);
+	ATTRIBUTE_NONNULL_ friend void get_package_property(OutputString *s, const PrintFormat *fmt, void *entity, const Property& property);
+	ATTRIBUTE_NONNULL_ friend void get_diff_package_property(OutputString *s, const PrintFormat *fmt, void *void_entity, const Property& property);
 
 	public:
-		ATTRIBUTE_NONNULL_ typedef void (*GetProperty)(OutputString *s, const PrintFormat *fmt, void *entity, const std::string& property);
+		ATTRIBUTE_NONNULL_ typedef void (*GetProperty)(OutputString *s, const PrintFormat *fmt, void *entity, const Property& property);
 		typedef std::vector<ExtendedVersion::Overlay> OverlayTranslations;
 		typedef std::vector<bool> OverlayUsed;
 
@@ -201,7 +229,9 @@ class PrintFormat {
 
 		static std::string::size_type currcolumn;
 
-		mutable UNORDERED_MAP<std::string, OutputString> user_variables;
+		/* Indexed by Property::slot; a deque keeps references valid
+		   when new variables are added while printing */
+		mutable std::deque<OutputString> user_variables;
 		/* Looping over variables is a bit tricky:
 		   We store the parsed thing in VarParserCache.
 		   Additionally, we store there whether we currently loop
@@ -230,6 +260,13 @@ class PrintFormat {
 		/* return true if something was actually printed */
 		ATTRIBUTE_NONNULL((3)) bool recPrint(OutputString *result, void *entity, GetProperty get_property, Node *root) const;
 
+		OutputString& user_variable(const Property& variable) const {
+			if(unlikely(variable.slot >= user_variables.size())) {
+				user_variables.resize(Property::slots());
+			}
+			return user_variables[variable.slot];
+		}
+
 		/* return true if something was actually printed */
 		bool printString(OutputString *result, const OutputString& output) const;
 
@@ -241,7 +278,7 @@ class PrintFormat {
 		ATTRIBUTE_NONNULL((2)) void get_installed(Package *package, Node *root) const;
 		ATTRIBUTE_NONNULL((2)) void get_versions_versorted(Package *package, Node *root, PrintFormat::VerVec *versions) const;
 		ATTRIBUTE_NONNULL((2)) void get_versions_slotsorted(Package *package, Node *root, PrintFormat::VerVec *versions) const;
-		ATTRIBUTE_NONNULL_ void get_pkg_property(OutputString *s, Package *package, const std::string& name) const;
+		ATTRIBUTE_NONNULL_ void get_pkg_property(OutputString *s, Package *package, const PropertyHandler& handler) const;
 
 		// It follows a list of indirect functions called in get_pkg_property():
 		// Functions with capital letters are parser destinations; other functions
@@ -486,8 +523,18 @@ class PrintFormat {
 			overlay_keytext(s, overlay, false);
 		}
 
+		/* Append to result instead of printing if result is not NULLPTR;
+		   return true if something was actually printed */
+		ATTRIBUTE_NONNULL((3, 6, 7, 8, 9)) bool print(OutputString *result, void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s);
+
 		/* return true if something was actually printed */
-		ATTRIBUTE_NONNULL((2, 5, 6, 7, 8)) bool print(void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s, bool check_only);
+		ATTRIBUTE_NONNULL((2, 5, 6, 7, 8)) bool print(void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s, bool check_only) {
+			if(unlikely(check_only)) {
+				OutputString dummy;
+				return print(&dummy, entity, get_property, root, dbheader, vardbpkg, ps, s);
+			}
+			return print(NULLPTR, entity, get_property, root, dbheader, vardbpkg, ps, s);
+		}
 
 		/* return true if something was actually printed */
 		ATTRIBUTE_NONNULL((2, 5, 6, 7, 8)) bool print(void *entity, GetProperty get_property, Node *root, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s) {
@@ -514,6 +561,18 @@ class PrintFormat {
 			return print(entity, root_node, dbheader, vardbpkg, ps, s);
 		}
 
+		/* Append to result; return true if something would have been printed */
+		ATTRIBUTE_NONNULL_ bool print(OutputString *result, void *entity, const DBHeader *dbheader, VarDbPkg *vardbpkg, const PortageSettings *ps, const SetStability *s) {
+			return print(result, entity, m_get_property, root_node, dbheader, vardbpkg, ps, s);
+		}
+
+		/**
+		Print the result of print(OutputString *, ...)
+		**/
+		void print_result(const OutputString& result) const {
+			printString(NULLPTR, result);
+		}
+
 		ATTRIBUTE_NONNULL((2, 3)) bool parseFormat(Node **rootnode, const char *fmt, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2)) bool parseFormat(const char *fmt, std::string *errtext) {
@@ -0,0 +1,217 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "output/print-jobs.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/outputsink.h"
+#include "eixTk/outputstring.h"
+#include "output/formatstring.h"
+
+using std::string;
+using std::vector;
+
+static bool write_all(int fd, const char *buf, size_t len) {
+	while(len != 0) {
+		ssize_t w(write(fd, buf, len));
+		if(unlikely(w < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		buf += w;
+		len -= w;
+	}
+	return true;
+}
+
+/**
+A part of the packages and the worker formatting it
+**/
+class PrintJob {
+	public:
+		PrintJobs::Packages::size_type begin, end;
+		pid_t pid;
+		int fd;
+		string data;
+
+		PrintJob() NOEXCEPT : begin(0), end(0), pid(-1), fd(-1) {
+		}
+};
+
+/**
+Worker process: Send the formated packages and the used overlays
+**/
+ATTRIBUTE_NORETURN static void run_job(int fd, PrintFormat *fmt, const PrintJobs::Packages& packages, const PrintJob& job, const DBHeader *header, VarDbPkg *vardb, const PortageSettings *ps, const SetStability *s, const PrintFormat::OverlayUsed *overlay_used, const bool *some_overlay_used) {
+	string data;
+	for(PrintJobs::Packages::size_type i(job.begin); likely(i != job.end); ++i) {
+		OutputString output;
+		bool printed(fmt->print(&output, packages[i], header, vardb, ps, s));
+		data.append(1, (printed ? '1' : '0'));
+		output.serialize(&data);
+	}
+	for(PrintFormat::OverlayUsed::const_iterator it(overlay_used->begin());
+		likely(it != overlay_used->end()); ++it) {
+		data.append(1, (*it ? '1' : '0'));
+	}
+	data.append(1, (*some_overlay_used ? '1' : '0'));
+	// Do not call exit(): This would clean up data of the parent
+	_exit(write_all(fd, data.c_str(), data.size()) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/**
+Read the output of all workers simultaneously
+@return false on read error
+**/
+static bool read_jobs(vector<PrintJob> *jobs) {
+	vector<struct pollfd> fds;
+	vector<PrintJob *> polled;
+	for(vector<PrintJob>::iterator it(jobs->begin()); likely(it != jobs->end()); ++it) {
+		if(it->fd != -1) {
+			struct pollfd p;
+			p.fd = it->fd;
+			p.events = POLLIN;
+			fds.PUSH_BACK(p);
+			polled.PUSH_BACK(&(*it));
+		}
+	}
+	bool ok(true);
+	while(!fds.empty()) {
+		if(unlikely(poll(&(fds[0]), fds.size(), -1) < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			ok = false;
+			break;
+		}
+		for(vector<struct pollfd>::size_type i(fds.size()); likely(i-- != 0); ) {
+			if(fds[i].revents == 0) {
+				continue;
+			}
+			char buf[65536];
+			ssize_t r(read(fds[i].fd, buf, sizeof(buf)));
+			if(r > 0) {
+				polled[i]->data.append(buf, r);
+				continue;
+			}
+			if(unlikely(r < 0)) {
+				if(errno == EINTR) {
+					continue;
+				}
+				ok = false;
+			}
+			fds.erase(fds.begin() + i);
+			polled.erase(polled.begin() + i);
+		}
+	}
+	for(vector<PrintJob>::iterator it(jobs->begin()); likely(it != jobs->end()); ++it) {
+		if(it->fd != -1) {
+			close(it->fd);
+			it->fd = -1;
+		}
+	}
+	return ok;
+}
+
+bool PrintJobs::format_packages(const Packages& packages, Results *results, const DBHeader *header, VarDbPkg *vardb, const PortageSettings *ps, const SetStability *s, PrintFormat::OverlayUsed *overlay_used, bool *some_overlay_used) {
+	results->clear();
+	results->resize(packages.size());
+	Packages::size_type count(m_jobs);
+	if(count > packages.size()) {
+		count = packages.size();
+	}
+	// Otherwise the workers would inherit (and print) the buffered output
+	OutputSink::flush();
+	vector<PrintJob> jobs(count);
+	for(Packages::size_type i(0); likely(i != count); ++i) {
+		PrintJob& job(jobs[i]);
+		job.begin = (packages.size() * i) / count;
+		job.end = (packages.size() * (i + 1)) / count;
+		int fd[2];
+		if(unlikely(pipe(fd) != 0)) {
+			continue;
+		}
+		job.pid = fork();
+		if(job.pid == 0) {
+			close(fd[0]);
+			run_job(fd[1], m_format, packages, job, header, vardb, ps, s, overlay_used, some_overlay_used);
+		}
+		close(fd[1]);
+		if(unlikely(job.pid == -1)) {
+			close(fd[0]);
+			continue;
+		}
+		job.fd = fd[0];
+	}
+	bool ok(read_jobs(&jobs));
+	for(vector<PrintJob>::iterator it(jobs.begin()); likely(it != jobs.end()); ++it) {
+		if(unlikely(it->pid == -1)) {
+			for(Packages::size_type i(it->begin); likely(i != it->end); ++i) {
+				Result& result((*results)[i]);
+				result.printed = m_format->print(&(result.output), packages[i], header, vardb, ps, s);
+			}
+			continue;
+		}
+		int status;
+		while(unlikely(waitpid(it->pid, &status, 0) == -1)) {
+			if(errno != EINTR) {
+				ok = false;
+				break;
+			}
+		}
+		if(unlikely(!ok) || unlikely(!WIFEXITED(status)) ||
+			unlikely(WEXITSTATUS(status) != EXIT_SUCCESS)) {
+			ok = false;
+			continue;
+		}
+		const char *pos(it->data.c_str());
+		const char *end(pos + it->data.size());
+		for(Packages::size_type i(it->begin); likely(i != it->end); ++i) {
+			if(unlikely(pos == end)) {
+				ok = false;
+				break;
+			}
+			Result& result((*results)[i]);
+			result.printed = (*(pos++) == '1');
+			if(unlikely(!result.output.unserialize(&pos, end))) {
+				ok = false;
+				break;
+			}
+		}
+		if(unlikely(!ok) ||
+			unlikely(static_cast<string::size_type>(end - pos) != overlay_used->size() + 1)) {
+			ok = false;
+			continue;
+		}
+		for(PrintFormat::OverlayUsed::iterator u(overlay_used->begin());
+			likely(u != overlay_used->end()); ++u) {
+			if(*(pos++) == '1') {
+				*u = true;
+			}
+		}
+		if(*pos == '1') {
+			*some_overlay_used = true;
+		}
+	}
+	return ok;
+}
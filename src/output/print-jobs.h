@@ -0,0 +1,71 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_OUTPUT_PRINT_JOBS_H_
+#define SRC_OUTPUT_PRINT_JOBS_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/outputstring.h"
+#include "output/formatstring.h"
+
+class DBHeader;
+class Package;
+class PortageSettings;
+class SetStability;
+class VarDbPkg;
+
+/**
+Format packages in worker processes.
+Formatting fills many caches (installed packages, masks, keywords, IUSE)
+which are shared by all packages. Therefore each worker is a process
+with its own copy of everything instead of a thread.
+The results are returned in the original order.
+**/
+class PrintJobs {
+	public:
+		typedef std::vector<Package *> Packages;
+
+		class Result {
+			public:
+				OutputString output;
+				bool printed;
+
+				Result() NOEXCEPT : printed(false) {
+				}
+		};
+		typedef std::vector<Result> Results;
+
+		/**
+		Upper bound for the number of worker processes
+		**/
+		static CONSTEXPR const unsigned int max_jobs = 32;
+
+		/**
+		@param jobs the maximal number of worker processes
+		**/
+		ATTRIBUTE_NONNULL_ PrintJobs(PrintFormat *fmt, unsigned int jobs) : m_format(fmt), m_jobs(jobs) {
+		}
+
+		/**
+		Format packages; overlays used by the format are marked in
+		overlay_used and some_overlay_used as by PrintFormat::print().
+		A part which cannot be passed to a worker is formatted directly.
+		@return false if a worker failed
+		**/
+		ATTRIBUTE_NONNULL_ bool format_packages(const Packages& packages, Results *results, const DBHeader *header, VarDbPkg *vardb, const PortageSettings *ps, const SetStability *s, PrintFormat::OverlayUsed *overlay_used, bool *some_overlay_used);
+
+	private:
+		PrintFormat *m_format;
+		unsigned int m_jobs;
+};
+
+#endif  // SRC_OUTPUT_PRINT_JOBS_H_
@@ -0,0 +1,341 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "output/print-json.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "database/header.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/outputsink.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/sysutils.h"
+#include "eixrc/eixrc.h"
+#include "output/formatstring.h"
+#include "output/print-xml.h"
+#include "portage/depend.h"
+#include "portage/extendedversion.h"
+#include "portage/instversion.h"
+#include "portage/overlay.h"
+#include "portage/package.h"
+#include "portage/vardbpkg.h"
+#include "portage/version.h"
+
+using std::string;
+
+PrintJson::PrintJson(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, EixRc *eixrc) :
+	print_overlay(eixrc->getBool("XML_OVERLAY")),
+	keywords_mode(PrintXml::get_keywords_mode(eixrc)),
+	hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability),
+	dateformat((*eixrc)["XML_DATE"]) {
+}
+
+/**
+Append key (including quotes, colon, and a leading comma) and the string
+**/
+static void append_field(string *out, const char *key, const string& value) {
+	out->append(key);
+	PrintJson::append_jsonstring(out, value);
+}
+
+/**
+Append key (including quotes, colon, and a leading comma) and the array
+**/
+static void append_array(string *out, const char *key, const WordVec& values) {
+	out->append(key);
+	out->append(1, '[');
+	for(WordVec::const_iterator it(values.begin()); likely(it != values.end()); ++it) {
+		if(it != values.begin()) {
+			out->append(1, ',');
+		}
+		PrintJson::append_jsonstring(out, *it);
+	}
+	out->append(1, ']');
+}
+
+static void append_iuse(string *out, const char *key, const IUseSet::IUseStd& s, IUse::Flags wanted) {
+	bool have_found(false);
+	for(IUseSet::IUseStd::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
+		if(((it->flags) & wanted) == 0) {
+			continue;
+		}
+		if(likely(have_found)) {
+			out->append(1, ',');
+		} else {
+			have_found = true;
+			out->append(key);
+			out->append(1, '[');
+		}
+		PrintJson::append_jsonstring(out, it->name());
+	}
+	if(have_found) {
+		out->append(1, ']');
+	}
+}
+
+void PrintJson::package(Package *pkg) {
+	// All output of a package is collected in the output buffer
+	string *out(OutputSink::buffer());
+	append_field(out, "{\"category\":", pkg->category);
+	append_field(out, ",\"name\":", pkg->name);
+	append_field(out, ",\"description\":", pkg->desc);
+	append_field(out, ",\"homepage\":", pkg->homepage);
+	append_field(out, ",\"licenses\":", pkg->licenses);
+	out->append(",\"versions\":[");
+
+	PrintXml::InstalledVersions have_inst;
+	PrintXml::get_installed(&have_inst, pkg, var_db_pkg, hdr);
+
+	for(Package::const_iterator ver(pkg->begin()); likely(ver != pkg->end()); ++ver) {
+		bool versionInstalled(false);
+		InstVersion *installedVersion(NULLPTR);
+		if(have_inst.count(*ver) != 0) {
+			if(var_db_pkg->isInstalled(*pkg, *ver, &installedVersion)) {
+				versionInstalled = true;
+				var_db_pkg->readInstDate(*pkg, installedVersion);
+				var_db_pkg->readEapi(*pkg, installedVersion);
+			}
+		}
+
+		if(ver != pkg->begin()) {
+			out->append(1, ',');
+		}
+		append_field(out, "{\"id\":", ver->getFull());
+		append_field(out, ",\"EAPI\":", ver->eapi.get());
+		ExtendedVersion::Overlay overlay_key(ver->overlay_key);
+		if(unlikely(overlay_key != 0)) {
+			if(print_format->is_virtual(overlay_key)) {
+				out->append(",\"virtual\":true");
+			}
+			const OverlayIdent& overlay(hdr->getOverlay(overlay_key));
+			if((print_overlay || overlay.label.empty()) && !(overlay.path.empty())) {
+				append_field(out, ",\"overlay\":", overlay.path);
+			}
+			if(!overlay.label.empty()) {
+				append_field(out, ",\"repository\":", overlay.label);
+			}
+		}
+		if(!ver->get_shortfullslot().empty()) {
+			append_field(out, ",\"slot\":", ver->get_longfullslot());
+		}
+		if(!ver->src_uri.empty()) {
+			append_field(out, ",\"srcURI\":", ver->src_uri);
+		}
+		if(versionInstalled) {
+			out->append(",\"installed\":true");
+			append_field(out, ",\"installDate\":", date_conv(dateformat.c_str(), installedVersion->instDate));
+			append_field(out, ",\"installEAPI\":", installedVersion->eapi.get());
+		}
+
+		WordVec mask_text, unmask_text;
+		PrintXml::get_mask_texts(&mask_text, &unmask_text, stability, *ver, pkg);
+		if(!mask_text.empty()) {
+			append_array(out, ",\"mask\":", mask_text);
+		}
+
+		if(unlikely(ver->have_reasons())) {
+			const Version::Reasons *reasons_ptr(ver->reasons_ptr());
+			bool have_found(false);
+			for(Version::Reasons::const_iterator it(reasons_ptr->begin());
+				unlikely(it != reasons_ptr->end()); ++it) {
+				const WordVec *vec(it->asWordVecPtr());
+				if((vec == NULLPTR) || (vec->empty())) {
+					continue;
+				}
+				if(likely(have_found)) {
+					append_array(out, ",", *vec);
+				} else {
+					have_found = true;
+					append_array(out, ",\"maskreason\":[", *vec);
+				}
+			}
+			if(have_found) {
+				out->append(1, ']');
+			}
+		}
+
+		if(!unmask_text.empty()) {
+			append_array(out, ",\"unmask\":", unmask_text);
+		}
+
+		if(!(ver->iuse.empty())) {
+			const IUseSet::IUseStd s(ver->iuse.asSorted());
+			append_iuse(out, ",\"iuse\":", s, IUse::USEFLAGS_NORMAL);
+			append_iuse(out, ",\"iuse_plus\":", s, IUse::USEFLAGS_PLUS);
+			append_iuse(out, ",\"iuse_minus\":", s, IUse::USEFLAGS_MINUS);
+		}
+		if(Version::use_required_use) {
+			const string& required_use(ver->required_use);
+			if(!(required_use.empty())) {
+				append_field(out, ",\"required_use\":", required_use);
+			}
+		}
+		if(versionInstalled) {
+			WordVec iuse_disabled, iuse_enabled;
+			var_db_pkg->readUse(*pkg, installedVersion);
+			const WordVec& inst_iuse(installedVersion->inst_iuse);
+			const WordSet& usedUse(installedVersion->usedUse);
+			for(WordVec::const_iterator iu(inst_iuse.begin()); likely(iu != inst_iuse.end()); ++iu) {
+				if(usedUse.count(*iu) == 0) {
+					iuse_disabled.PUSH_BACK(*iu);
+				} else {
+					iuse_enabled.PUSH_BACK(*iu);
+				}
+			}
+			if(!iuse_disabled.empty()) {
+				append_array(out, ",\"use_disabled\":", iuse_disabled);
+			}
+			if(!iuse_enabled.empty()) {
+				append_array(out, ",\"use_enabled\":", iuse_enabled);
+			}
+		}
+
+		WordVec flags;
+		PrintXml::get_restrict_names(&flags, ver->restrictFlags);
+		if(unlikely(!flags.empty())) {
+			append_array(out, ",\"restrict\":", flags);
+		}
+		PrintXml::get_properties_names(&flags, ver->propertiesFlags);
+		if(unlikely(!flags.empty())) {
+			append_array(out, ",\"properties\":", flags);
+		}
+
+		if(keywords_mode != PrintXml::KW_NONE) {
+			bool print_full, print_effective;
+			string full_kw, eff_kw;
+			PrintXml::get_keywords(&print_full, &print_effective, &full_kw, &eff_kw, keywords_mode, *ver);
+			if(print_full) {
+				append_field(out, ",\"keywords\":", full_kw);
+			}
+			if(print_effective) {
+				append_field(out, ",\"effective_keywords\":", eff_kw);
+			}
+		}
+
+		if(Depend::use_depend) {
+			const string& depend = ver->depend.get_depend();
+			if(!depend.empty()) {
+				append_field(out, ",\"depend\":", depend);
+			}
+			const string& rdepend = ver->depend.get_rdepend();
+			if(!rdepend.empty()) {
+				append_field(out, ",\"rdepend\":", rdepend);
+			}
+			const string& pdepend = ver->depend.get_pdepend();
+			if(!pdepend.empty()) {
+				append_field(out, ",\"pdepend\":", pdepend);
+			}
+			const string& bdepend = ver->depend.get_bdepend();
+			if(!bdepend.empty()) {
+				append_field(out, ",\"bdepend\":", bdepend);
+			}
+		}
+		out->append(1, '}');
+	}
+	out->append("]}\n");
+	OutputSink::written();
+}  // NOLINT(readability/fn_size)
+
+/**
+@return the length of the valid UTF-8 sequence at s which starts with a
+non-ASCII byte, or 0 if the sequence is invalid
+**/
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static string::size_type utf8_length(const unsigned char *s, string::size_type avail);
+static string::size_type utf8_length(const unsigned char *s, string::size_type avail) {
+	unsigned char c(s[0]);
+	// Range of the second byte: Excludes overlong forms, surrogates,
+	// and code points beyond U+10FFFF
+	unsigned char lo(0x80), hi(0xBF);
+	string::size_type n;
+	if(c < 0xC2) {
+		return 0;
+	} else if(c < 0xE0) {
+		n = 2;
+	} else if(c < 0xF0) {
+		n = 3;
+		if(c == 0xE0) {
+			lo = 0xA0;
+		} else if(c == 0xED) {
+			hi = 0x9F;
+		}
+	} else if(c < 0xF5) {
+		n = 4;
+		if(c == 0xF0) {
+			lo = 0x90;
+		} else if(c == 0xF4) {
+			hi = 0x8F;
+		}
+	} else {
+		return 0;
+	}
+	if((avail < n) || (s[1] < lo) || (s[1] > hi)) {
+		return 0;
+	}
+	for(string::size_type i(2); i < n; ++i) {
+		if((s[i] & 0xC0) != 0x80) {
+			return 0;
+		}
+	}
+	return n;
+}
+
+void PrintJson::append_jsonstring(string *dest, const string& s) {
+	static CONSTEXPR const char hex[] = "0123456789abcdef";
+	dest->append(1, '"');
+	const char *str(s.c_str());
+	string::size_type len(s.size());
+	string::size_type clean(0);
+	for(string::size_type i(0); likely(i < len); ++i) {
+		unsigned char c(str[i]);
+		if(likely((c >= 0x20) && (c < 0x80) && (c != '"') && (c != '\\'))) {
+			continue;
+		}
+		if(c >= 0x80) {
+			string::size_type n(utf8_length(reinterpret_cast<const unsigned char *>(str + i), len - i));
+			if(likely(n != 0)) {
+				i += n - 1;
+				continue;
+			}
+		}
+		// Clean runs are copied wholesale
+		dest->append(str + clean, i - clean);
+		clean = i + 1;
+		if(c >= 0x80) {
+			// JSON must be valid UTF-8
+			dest->append("\\ufffd");
+			continue;
+		}
+		switch(c) {
+			case '"':
+				dest->append("\\\"");
+				break;
+			case '\\':
+				dest->append("\\\\");
+				break;
+			case '\n':
+				dest->append("\\n");
+				break;
+			case '\t':
+				dest->append("\\t");
+				break;
+			case '\r':
+				dest->append("\\r");
+				break;
+			default:
+				dest->append("\\u00");
+				dest->append(1, hex[c >> 4]);
+				dest->append(1, hex[c & 0x0F]);
+				break;
+		}
+	}
+	dest->append(str + clean, len - clean);
+	dest->append(1, '"');
+}
@@ -0,0 +1,57 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_OUTPUT_PRINT_JSON_H_
+#define SRC_OUTPUT_PRINT_JSON_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/null.h"
+#include "output/print-formats.h"
+#include "output/print-xml.h"
+#include "portage/package.h"
+
+class EixRc;
+class DBHeader;
+class VarDbPkg;
+class PrintFormat;
+class SetStability;
+
+/**
+Newline-delimited JSON: One object per package with the data of --xml.
+The XML_* variables are honoured.
+**/
+class PrintJson FINAL : public PrintFormats {
+	protected:
+		bool print_overlay;
+		PrintXml::KeywordsMode keywords_mode;
+
+		const DBHeader *hdr;
+		VarDbPkg *var_db_pkg;
+		const PrintFormat *print_format;
+		const SetStability *stability;
+		std::string dateformat;
+
+	public:
+		ATTRIBUTE_NONNULL_ PrintJson(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, EixRc *eixrc);
+
+		PrintJson() : print_overlay(false), keywords_mode(PrintXml::KW_NONE), hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), dateformat("%s") {
+		}
+
+		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
+
+		/**
+		Append s to dest as a quoted JSON string
+		**/
+		ATTRIBUTE_NONNULL_ static void append_jsonstring(std::string *dest, const std::string& s);
+};
+
+#endif  // SRC_OUTPUT_PRINT_JSON_H_
@@ -27,6 +27,7 @@
 #include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/unordered_set.h"
 WSUGGEST_FINAL_METHODS_OFF
@@ -52,12 +53,49 @@ static void set_key_flags(eix_proto::KeyFlags *key_flags, KeywordsFlags key);
 static void add_restrictions(eix_proto::Restrictions *restrictions, ExtendedVersion::Restrict restrict);
 static void add_properties(eix_proto::Properties *properties, ExtendedVersion::Restrict props);
 
+static CONSTEXPR const char stream_format[] = "eix-proto-stream";
+static CONSTEXPR const unsigned int stream_version = 1;
+
+/**
+Write message preceded by its length as a varint
+**/
+static void write_delimited(const google::protobuf::MessageLite& message) {
+	string data;
+	message.SerializeToString(&data);
+	string *buffer(OutputSink::buffer());
+	string::size_type len(data.size());
+	for(; len >= 0x80; len >>= 7) {
+		buffer->append(1, static_cast<char>((len & 0x7F) | 0x80));
+	}
+	buffer->append(1, static_cast<char>(len));
+	buffer->append(data);
+	OutputSink::written();
+}
+
 void PrintProto::start() {
+	if(stream) {
+		stream_started = true;
+		eix_proto::StreamHeader header;
+		header.set_format(stream_format);
+		header.set_version(stream_version);
+		write_delimited(header);
+		return;
+	}
 	collection = new eix_proto::Collection();
 	category_index.clear();
 }
 
 void PrintProto::package(Package *pkg) {
+	if(stream) {
+		if(unlikely(!stream_started)) {
+			start();
+		}
+		eix_proto::Category category;
+		category.set_category(pkg->category);
+		fill_package(category.add_package(), pkg);
+		write_delimited(category);
+		return;
+	}
 	if(collection == NULLPTR) {
 		start();
 	}
@@ -74,7 +112,10 @@ void PrintProto::package(Package *pkg) {
 	} else {
 		category = collection->add_category();
 	}
-	eix_proto::Package *package = category->add_package();
+	fill_package(category->add_package(), pkg);
+}
+
+void PrintProto::fill_package(eix_proto::Package *package, Package *pkg) {
 	package->set_name(pkg->name);
 	package->set_description(pkg->desc);
 	package->set_homepage(pkg->homepage);
@@ -169,7 +210,7 @@ void PrintProto::package(Package *pkg) {
 		}
 
 		if(!(ver->iuse.empty())) {
-			const IUseSet::IUseStd& s(ver->iuse.asStd());
+			const IUseSet::IUseStd s(ver->iuse.asSorted());
 			for(IUseSet::IUseStd::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
 				IUse::Flags flags = it->flags;
 				if((flags & IUse::USEFLAGS_NORMAL) != 0) {
@@ -357,7 +398,9 @@ void PrintProto::finish() {
 	if(collection == NULLPTR) {
 		return;
 	}
+	OutputSink::flush();
 	collection->SerializeToOstream(&std::cout);
+	std::cout.flush();
 	delete collection;
 	collection = NULLPTR;
 }
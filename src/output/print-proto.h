@@ -26,6 +26,7 @@ class SetStability;
 
 namespace eix_proto {
 class Collection;
+class Package;
 }
 
 class PrintProto FINAL : public PrintFormats {
@@ -37,12 +38,19 @@ class PrintProto FINAL : public PrintFormats {
 		eix_proto::Collection *collection;
 		typedef UNORDERED_MAP<std::string, int> CategoryIndex;
 		CategoryIndex category_index;
+		bool stream, stream_started;
+
+		ATTRIBUTE_NONNULL_ void fill_package(eix_proto::Package *package, Package *pkg);
 
 	public:
-		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability) :
-			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR) {}
+		/**
+		@param streaming output a length-delimited message for each match
+		instead of a single Collection at the end
+		**/
+		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, bool streaming) :
+			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR), stream(streaming), stream_started(false) {}
 
-		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR) {}
+		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR), stream(false), stream_started(false) {}
 
 		void start() OVERRIDE;
 
@@ -9,6 +9,8 @@
 #include "output/print-xml.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <cstring>
+
 #include <set>
 #include <string>
 
@@ -17,6 +19,7 @@
 #include "eixTk/formated.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/outputsink.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/sysutils.h"
 #include "eixTk/unordered_set.h"
@@ -38,7 +41,7 @@ using std::string;
 
 const PrintXml::XmlVersion PrintXml::current;
 
-static void print_iuse(const IUseSet::IUseStd& s, IUse::Flags wanted, const char *dflt);
+static void print_iuse(string *out, const IUseSet::IUseStd& s, IUse::Flags wanted, const char *dflt);
 
 void PrintXml::runclear() {
 	started = false;
@@ -54,35 +57,39 @@ void PrintXml::clear(EixRc *eixrc) {
 	} else {
 		dateformat = (*eixrc)["XML_DATE"];
 		print_overlay = eixrc->getBool("XML_OVERLAY");
-		static CONSTEXPR const char *values[] = {
-			"none",
-			"both",
-			"effective*",
-			"effective",
-			"full*",
-			"full",
-			NULLPTR };
-		switch(eixrc->getTinyTextlist("XML_KEYWORDS", values)) {
-			case 0:
-			case -1: keywords_mode = KW_NONE;  break;
-			case -2: keywords_mode = KW_BOTH;  break;
-			case -3: keywords_mode = KW_EFFS;  break;
-			case -4: keywords_mode = KW_EFF;   break;
-			case -5: keywords_mode = KW_FULLS; break;
-			default: keywords_mode = KW_FULL;  break;
-		}
+		keywords_mode = get_keywords_mode(eixrc);
 	}
 	runclear();
 }
 
+PrintXml::KeywordsMode PrintXml::get_keywords_mode(EixRc *eixrc) {
+	static CONSTEXPR const char *values[] = {
+		"none",
+		"both",
+		"effective*",
+		"effective",
+		"full*",
+		"full",
+		NULLPTR };
+	switch(eixrc->getTinyTextlist("XML_KEYWORDS", values)) {
+		case 0:
+		case -1: return KW_NONE;
+		case -2: return KW_BOTH;
+		case -3: return KW_EFFS;
+		case -4: return KW_EFF;
+		case -5: return KW_FULLS;
+		default: return KW_FULL;
+	}
+}
+
 void PrintXml::start() {
 	if(unlikely(started)) {
 		return;
 	}
 	started = true;
 
-	eix::say("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-		"<eixdump version=\"%s\">") % current;
+	OutputSink::write(eix::format("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<eixdump version=\"%s\">\n") % current);
 }
 
 void PrintXml::finish() {
@@ -91,80 +98,78 @@ void PrintXml::finish() {
 	}
 
 	if(count) {
-		eix::say("\t</category>");
+		OutputSink::write("\t</category>\n</eixdump>\n");
+	} else {
+		OutputSink::write("</eixdump>\n");
 	}
-	eix::say("</eixdump>");
 
 	runclear();
 }
 
-static void print_iuse(const IUseSet::IUseStd& s, IUse::Flags wanted, const char *dflt) {
+static void print_iuse(string *out, const IUseSet::IUseStd& s, IUse::Flags wanted, const char *dflt) {
 	bool have_found(false);
 	for(IUseSet::IUseStd::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
 		if(((it->flags) & wanted) == 0) {
 			continue;
 		}
 		if(likely(have_found)) {
-			eix::print(" %s") % PrintXml::escape_xmlstring(false, it->name());
-			continue;
-		}
-		have_found = true;
-		if(dflt != NULLPTR) {
-			eix::print("\t\t\t\t<iuse default=\"%s\">") % dflt;
+			out->append(1, ' ');
 		} else {
-			eix::print("\t\t\t\t<iuse>");
+			have_found = true;
+			if(dflt != NULLPTR) {
+				out->append("\t\t\t\t<iuse default=\"");
+				out->append(dflt);
+				out->append("\">");
+			} else {
+				out->append("\t\t\t\t<iuse>");
+			}
 		}
-		eix::print() % PrintXml::escape_xmlstring(false, it->name());
+		PrintXml::append_xmlstring(out, false, it->name());
 	}
 	if(have_found) {
-		eix::say("</iuse>");
+		out->append("</iuse>\n");
 	}
 }
 
+/**
+Append prefix<name>, the escaped text and </name> to out
+**/
+static void append_element(string *out, const char *prefix, const char *name, const string& text) {
+	out->append(prefix);
+	out->append(1, '<');
+	out->append(name);
+	out->append(1, '>');
+	PrintXml::append_xmlstring(out, false, text);
+	out->append("</");
+	out->append(name);
+	out->append(">\n");
+}
+
 void PrintXml::package(Package *pkg) {
 	if(unlikely(!started)) {
 		start();
 	}
+	// All output of a package is collected in the output buffer
+	string *out(OutputSink::buffer());
 	if(unlikely(curcat != pkg->category)) {
 		if(!curcat.empty()) {
-			eix::say("\t</category>");
+			out->append("\t</category>\n");
 		}
 		curcat = pkg->category;
-		eix::say("\t<category name=\"%s\">") % escape_xmlstring(true, curcat);
+		out->append("\t<category name=\"");
+		append_xmlstring(out, true, curcat);
+		out->append("\">\n");
 	}
 	// category, name, desc, homepage, licenses;
-	eix::say("\t\t<package name=\"%s\">")
-		% escape_xmlstring(true, pkg->name);
-	say_xml_element("\t\t\t", "description", pkg->desc);
-	say_xml_element("\t\t\t", "homepage", pkg->homepage);
-	say_xml_element("\t\t\t", "licenses", pkg->licenses);
-
-	UNORDERED_SET<const Version*> have_inst;
-	if((likely(var_db_pkg != NULLPTR)) && var_db_pkg->isInstalled(*pkg)) {
-		set<BasicVersion> know_inst;
-		// First we check which versions are installed with correct overlays.
-		if(likely(hdr != NULLPTR)) {
-			// Package is a 'list' of Versions with added members ^^
-			for(Package::const_iterator ver(pkg->begin());
-				likely(ver != pkg->end()); ++ver) {
-				if(var_db_pkg->isInstalledVersion(*pkg, *ver, *hdr) > 0) {
-					know_inst.INSERT(**ver);
-					have_inst.INSERT(*ver);
-				}
-			}
-		}
-		// From the remaining ones we choose the last.
-		// The following should actually be const_reverse_iterator,
-		// but some compilers would then need a cast of rend(),
-		// see https://bugs.gentoo.org/show_bug.cgi?id=354071
-		for(Package::reverse_iterator ver(pkg->rbegin());
-			likely(ver != pkg->rend()); ++ver) {
-			if(know_inst.count(**ver) == 0) {
-				know_inst.INSERT(**ver);
-				have_inst.INSERT(*ver);
-			}
-		}
-	}
+	out->append("\t\t<package name=\"");
+	append_xmlstring(out, true, pkg->name);
+	out->append("\">\n");
+	append_xml_element(out, "\t\t\t", "description", pkg->desc);
+	append_xml_element(out, "\t\t\t", "homepage", pkg->homepage);
+	append_xml_element(out, "\t\t\t", "licenses", pkg->licenses);
+
+	InstalledVersions have_inst;
+	get_installed(&have_inst, pkg, var_db_pkg, hdr);
 
 	for(Package::const_iterator ver(pkg->begin()); likely(ver != pkg->end()); ++ver) {
 		bool versionInstalled(false);
@@ -177,108 +182,55 @@ void PrintXml::package(Package *pkg) {
 			}
 		}
 
-		eix::print("\t\t\t<version id=\"%s\" EAPI=\"%s\"")
-			% escape_xmlstring(true, ver->getFull())
-			% escape_xmlstring(true, ver->eapi.get());
+		out->append("\t\t\t<version id=\"");
+		append_xmlstring(out, true, ver->getFull());
+		out->append("\" EAPI=\"");
+		append_xmlstring(out, true, ver->eapi.get());
+		out->append(1, '"');
 		ExtendedVersion::Overlay overlay_key(ver->overlay_key);
 		if(unlikely(overlay_key != 0)) {
 			if(print_format->is_virtual(overlay_key)) {
-				eix::print(" virtual=\"1\"");
+				out->append(" virtual=\"1\"");
 			}
 			const OverlayIdent& overlay(hdr->getOverlay(overlay_key));
 			if((print_overlay || overlay.label.empty()) && !(overlay.path.empty())) {
-				eix::print(" overlay=\"%s\"")
-					% escape_xmlstring(true, overlay.path);
+				out->append(" overlay=\"");
+				append_xmlstring(out, true, overlay.path);
+				out->append(1, '"');
 			}
 			if(!overlay.label.empty()) {
-				eix::print(" repository=\"%s\"")
-					% escape_xmlstring(true, overlay.label);
+				out->append(" repository=\"");
+				append_xmlstring(out, true, overlay.label);
+				out->append(1, '"');
 			}
 		}
 		if(!ver->get_shortfullslot().empty()) {
-			eix::print(" slot=\"%s\"")
-				% escape_xmlstring(true, ver->get_longfullslot());
+			out->append(" slot=\"");
+			append_xmlstring(out, true, ver->get_longfullslot());
+			out->append(1, '"');
 		}
 		if(!ver->src_uri.empty()) {
-			eix::print(" srcURI=\"%s\"")
-				% escape_xmlstring(true, ver->src_uri);
+			out->append(" srcURI=\"");
+			append_xmlstring(out, true, ver->src_uri);
+			out->append(1, '"');
 		}
 		if(versionInstalled) {
-			eix::print(" installed=\"1\" installDate=\"%s\" installEAPI=\"%s\"")
-				% escape_xmlstring(true, date_conv(dateformat.c_str(), installedVersion->instDate))
-				% escape_xmlstring(true, installedVersion->eapi.get());
+			out->append(" installed=\"1\" installDate=\"");
+			append_xmlstring(out, true, date_conv(dateformat.c_str(), installedVersion->instDate));
+			out->append("\" installEAPI=\"");
+			append_xmlstring(out, true, installedVersion->eapi.get());
+			out->append(1, '"');
 		}
-		eix::say('>');
-
-		MaskFlags currmask(ver->maskflags);
-		KeywordsFlags currkey(ver->keyflags);
-		MaskFlags wasmask;
-		KeywordsFlags waskey;
-		stability->calc_version_flags(false, &wasmask, &waskey, *ver, pkg);
+		out->append(">\n");
 
 		WordVec mask_text, unmask_text;
-		// The following might give a memory leak with -flto for unknown reasons:
-		// mask_text.PUSH_BACK("FOO") or mask_text.PUSH_BACK("BAR")
-		if(wasmask.isHardMasked()) {
-			if(currmask.isProfileMask()) {
-				mask_text.push_back("profile");
-			} else if(currmask.isPackageMask()) {
-				mask_text.push_back("hard");
-			} else if(wasmask.isProfileMask()) {
-				mask_text.push_back("profile");
-				unmask_text.push_back("package_unmask");
-			} else {
-				mask_text.push_back("hard");
-				unmask_text.push_back("package_unmask");
-			}
-		} else if(currmask.isHardMasked()) {
-			mask_text.push_back("package_mask");
-		}
-
-		if(currkey.isStable()) {
-			if(waskey.isStable()) {
-				//
-			} else if(waskey.isUnstable()) {
-				mask_text.push_back("keyword");
-				unmask_text.push_back("package_keywords");
-			} else if(waskey.isMinusKeyword()) {
-				mask_text.push_back("minus_keyword");
-				unmask_text.push_back("package_keywords");
-			} else if(waskey.isAlienStable()) {
-				mask_text.push_back("alien_stable");
-				unmask_text.push_back("package_keywords");
-			} else if(waskey.isAlienUnstable()) {
-				mask_text.push_back("alien_unstable");
-				unmask_text.push_back("package_keywords");
-			} else if(waskey.isMinusUnstable()) {
-				mask_text.push_back("minus_unstable");
-				unmask_text.push_back("package_keywords");
-			} else if(waskey.isMinusAsterisk()) {
-				mask_text.push_back("minus_asterisk");
-				unmask_text.push_back("package_keywords");
-			} else {
-				mask_text.push_back("missing_keyword");
-				unmask_text.push_back("package_keywords");
-			}
-		} else if(currkey.isUnstable()) {
-			mask_text.push_back("keyword");
-		} else if(currkey.isMinusKeyword()) {
-			mask_text.push_back("minus_keyword");
-		} else if(currkey.isAlienStable()) {
-			mask_text.push_back("alien_stable");
-		} else if(currkey.isAlienUnstable()) {
-			mask_text.push_back("alien_unstable");
-		} else if(currkey.isMinusUnstable()) {
-			mask_text.push_back("minus_unstable");
-		} else if(currkey.isMinusAsterisk()) {
-			mask_text.push_back("minus_asterisk");
-		} else {
-			mask_text.push_back("missing_keyword");
-		}
+		get_mask_texts(&mask_text, &unmask_text, stability, *ver, pkg);
 
 		for(WordVec::const_iterator it(mask_text.begin());
 			unlikely(it != mask_text.end()); ++it) {
-			eix::say("\t\t\t\t<mask type=\"%s\"/>") % (*it);
+			out->append("\t\t\t\t<mask type=\"");
+			out->append(*it);
+			out->append("\"/>\n");
 		}
 
 		if(unlikely(ver->have_reasons())) {
@@ -289,37 +241,39 @@ void PrintXml::package(Package *pkg) {
 				if((vec == NULLPTR) || (vec->empty())) {
 					continue;
 				}
-				eix::print("\t\t\t\t<maskreason>");
+				out->append("\t\t\t\t<maskreason>");
 				bool pret(false);
 				for(WordVec::const_iterator wit(vec->begin());
 					likely(wit != vec->end()); ++wit) {
 					if(likely(pret)) {
-						eix::say_empty();
+						out->append(1, '\n');
 					} else {
 						pret = true;
 					}
-					eix::say() % escape_xmlstring(false, *wit);
+					append_xmlstring(out, false, *wit);
+					out->append(1, '\n');
 				}
-				eix::say("</maskreason>");
+				out->append("</maskreason>\n");
 			}
 		}
 
 		for(WordVec::const_iterator it(unmask_text.begin());
 			unlikely(it != unmask_text.end()); ++it) {
-			eix::say("\t\t\t\t<unmask type=\"%s\"/>") % (*it);
+			out->append("\t\t\t\t<unmask type=\"");
+			out->append(*it);
+			out->append("\"/>\n");
 		}
 
 		if(!(ver->iuse.empty())) {
-			const IUseSet::IUseStd& s(ver->iuse.asStd());
-			print_iuse(s, IUse::USEFLAGS_NORMAL, NULLPTR);
-			print_iuse(s, IUse::USEFLAGS_PLUS, "1");
-			print_iuse(s, IUse::USEFLAGS_MINUS, "-1");
+			const IUseSet::IUseStd s(ver->iuse.asSorted());
+			print_iuse(out, s, IUse::USEFLAGS_NORMAL, NULLPTR);
+			print_iuse(out, s, IUse::USEFLAGS_PLUS, "1");
+			print_iuse(out, s, IUse::USEFLAGS_MINUS, "-1");
 		}
 		if(Version::use_required_use) {
 			string &required_use(ver->required_use);
 			if(!(required_use.empty())) {
-				eix::say("\t\t\t\t<required_use>%s</required_use>")
-					% escape_xmlstring(false, required_use);
+				append_element(out, "\t\t\t\t", "required_use", required_use);
 			}
 		}
 		if(versionInstalled) {
@@ -341,165 +295,286 @@ void PrintXml::package(Package *pkg) {
 				}
 			}
 			if(!iuse_disabled.empty()) {
-				eix::say("\t\t\t\t<use enabled=\"0\">%s</use>")
-					% escape_xmlstring(false, iuse_disabled);
+				out->append("\t\t\t\t<use enabled=\"0\">");
+				append_xmlstring(out, false, iuse_disabled);
+				out->append("</use>\n");
 			}
 			if(!iuse_enabled.empty()) {
-				eix::say("\t\t\t\t<use enabled=\"1\">%s</use>")
-					% escape_xmlstring(false, iuse_enabled);
+				out->append("\t\t\t\t<use enabled=\"1\">");
+				append_xmlstring(out, false, iuse_enabled);
+				out->append("</use>\n");
 			}
 		}
 
-		ExtendedVersion::Restrict restrict(ver->restrictFlags);
-		if(unlikely(restrict != ExtendedVersion::RESTRICT_NONE)) {
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_BINCHECKS) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"binchecks\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_STRIP) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"strip\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_TEST) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"test\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_USERPRIV) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"userpriv\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_INSTALLSOURCES) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"installsources\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_FETCH) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"fetch\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_MIRROR) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"mirror\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_PRIMARYURI) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"primaryuri\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_BINDIST) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"bindist\"/>");
-			}
-			if(unlikely((restrict & ExtendedVersion::RESTRICT_PARALLEL) != 0)) {
-				eix::say("\t\t\t\t<restrict flag=\"parallel\"/>");
-			}
+		WordVec flags;
+		get_restrict_names(&flags, ver->restrictFlags);
+		for(WordVec::const_iterator it(flags.begin());
+			unlikely(it != flags.end()); ++it) {
+			out->append("\t\t\t\t<restrict flag=\"");
+			out->append(*it);
+			out->append("\"/>\n");
 		}
-		ExtendedVersion::Restrict properties(ver->propertiesFlags);
-		if(unlikely(properties != ExtendedVersion::PROPERTIES_NONE)) {
-			if(unlikely((properties & ExtendedVersion::PROPERTIES_INTERACTIVE) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"interactive\"/>");
-			}
-			if(unlikely((properties & ExtendedVersion::PROPERTIES_LIVE) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"live\"/>");
-			}
-			if(unlikely((properties & ExtendedVersion::PROPERTIES_VIRTUAL) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"virtual\"/>");
-			}
-			if(unlikely((properties & ExtendedVersion::PROPERTIES_SET) != 0)) {
-				eix::say("\t\t\t\t<properties flag=\"set\"/>");
-			}
+		get_properties_names(&flags, ver->propertiesFlags);
+		for(WordVec::const_iterator it(flags.begin());
+			unlikely(it != flags.end()); ++it) {
+			out->append("\t\t\t\t<properties flag=\"");
+			out->append(*it);
+			out->append("\"/>\n");
 		}
 
 		if(keywords_mode != KW_NONE) {
-			bool print_full(keywords_mode != KW_EFF);
-			bool print_effective(keywords_mode != KW_FULL);
+			bool print_full, print_effective;
 			string full_kw, eff_kw;
+			get_keywords(&print_full, &print_effective, &full_kw, &eff_kw, keywords_mode, *ver);
 			if(print_full) {
-				full_kw = ver->get_full_keywords();
+				append_xml_element(out, "\t\t\t\t", "keywords", full_kw);
 			}
 			if(print_effective) {
-				eff_kw = ver->get_effective_keywords();
-			}
-			if((keywords_mode == KW_FULLS) || (keywords_mode == KW_EFFS)) {
-				if(likely(full_kw == eff_kw)) {
-					if(keywords_mode == KW_FULLS) {
-						print_effective = false;
-					} else {
-						print_full = false;
-					}
-				}
-			}
-			if(print_full) {
-				say_xml_element("\t\t\t\t", "keywords", full_kw);
-			}
-			if(print_effective) {
-				say_xml_element("\t\t\t\t", "effective_keywords", eff_kw);
+				append_xml_element(out, "\t\t\t\t", "effective_keywords", eff_kw);
 			}
 		}
 
 		if(Depend::use_depend) {
 			const string& depend = ver->depend.get_depend();
 			if(!depend.empty()) {
-				eix::say("\t\t\t\t<depend>%s</depend>")
-					% escape_xmlstring(false, depend);
+				append_element(out, "\t\t\t\t", "depend", depend);
 			}
 			const string& rdepend = ver->depend.get_rdepend();
 			if(!rdepend.empty()) {
-				eix::say("\t\t\t\t<rdepend>%s</rdepend>")
-					% escape_xmlstring(false, rdepend);
+				append_element(out, "\t\t\t\t", "rdepend", rdepend);
 			}
 			const string& pdepend = ver->depend.get_pdepend();
 			if(!pdepend.empty()) {
-				eix::say("\t\t\t\t<pdepend>%s</pdepend>")
-					% escape_xmlstring(false, pdepend);
+				append_element(out, "\t\t\t\t", "pdepend", pdepend);
 			}
 			const string& bdepend = ver->depend.get_bdepend();
 			if(!bdepend.empty()) {
-				eix::say("\t\t\t\t<bdepend>%s</bdepend>")
-					% escape_xmlstring(false, bdepend);
+				append_element(out, "\t\t\t\t", "bdepend", bdepend);
 			}
 		}
-		eix::say("\t\t\t</version>");
+		out->append("\t\t\t</version>\n");
 	}
-	eix::say("\t\t</package>");
+	out->append("\t\t</package>\n");
+	OutputSink::written();
 	++count;
 }  // NOLINT(readability/fn_size)
 
-string PrintXml::escape_xmlstring(bool quoted, const string& s) {
-	string ret;
-	string::size_type prev(0);
-	string::size_type len(s.length());
-	for(string::size_type i(0); likely(i < len); ++i) {
-		const char *replace;
-		switch(s[i]) {
+void PrintXml::get_installed(InstalledVersions *have_inst, Package *pkg, VarDbPkg *vardb, const DBHeader *header) {
+	if((unlikely(vardb == NULLPTR)) || !vardb->isInstalled(*pkg)) {
+		return;
+	}
+	set<BasicVersion> know_inst;
+	// First we check which versions are installed with correct overlays.
+	if(likely(header != NULLPTR)) {
+		// Package is a 'list' of Versions with added members ^^
+		for(Package::const_iterator ver(pkg->begin());
+			likely(ver != pkg->end()); ++ver) {
+			if(vardb->isInstalledVersion(*pkg, *ver, *header) > 0) {
+				know_inst.INSERT(**ver);
+				have_inst->INSERT(*ver);
+			}
+		}
+	}
+	// From the remaining ones we choose the last.
+	// The following should actually be const_reverse_iterator,
+	// but some compilers would then need a cast of rend(),
+	// see https://bugs.gentoo.org/show_bug.cgi?id=354071
+	for(Package::reverse_iterator ver(pkg->rbegin());
+		likely(ver != pkg->rend()); ++ver) {
+		if(know_inst.count(**ver) == 0) {
+			know_inst.INSERT(**ver);
+			have_inst->INSERT(*ver);
+		}
+	}
+}
+
+void PrintXml::get_restrict_names(WordVec *names, ExtendedVersion::Restrict restrict) {
+	names->clear();
+	if(likely(restrict == ExtendedVersion::RESTRICT_NONE)) {
+		return;
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_BINCHECKS) != 0)) {
+		names->PUSH_BACK("binchecks");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_STRIP) != 0)) {
+		names->PUSH_BACK("strip");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_TEST) != 0)) {
+		names->PUSH_BACK("test");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_USERPRIV) != 0)) {
+		names->PUSH_BACK("userpriv");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_INSTALLSOURCES) != 0)) {
+		names->PUSH_BACK("installsources");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_FETCH) != 0)) {
+		names->PUSH_BACK("fetch");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_MIRROR) != 0)) {
+		names->PUSH_BACK("mirror");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_PRIMARYURI) != 0)) {
+		names->PUSH_BACK("primaryuri");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_BINDIST) != 0)) {
+		names->PUSH_BACK("bindist");
+	}
+	if(unlikely((restrict & ExtendedVersion::RESTRICT_PARALLEL) != 0)) {
+		names->PUSH_BACK("parallel");
+	}
+}
+
+void PrintXml::get_properties_names(WordVec *names, ExtendedVersion::Properties properties) {
+	names->clear();
+	if(likely(properties == ExtendedVersion::PROPERTIES_NONE)) {
+		return;
+	}
+	if(unlikely((properties & ExtendedVersion::PROPERTIES_INTERACTIVE) != 0)) {
+		names->PUSH_BACK("interactive");
+	}
+	if(unlikely((properties & ExtendedVersion::PROPERTIES_LIVE) != 0)) {
+		names->PUSH_BACK("live");
+	}
+	if(unlikely((properties & ExtendedVersion::PROPERTIES_VIRTUAL) != 0)) {
+		names->PUSH_BACK("virtual");
+	}
+	if(unlikely((properties & ExtendedVersion::PROPERTIES_SET) != 0)) {
+		names->PUSH_BACK("set");
+	}
+}
+
+void PrintXml::get_keywords(bool *print_full, bool *print_effective, string *full_kw, string *eff_kw, KeywordsMode mode, const Version *ver) {
+	*print_full = ((mode != KW_NONE) && (mode != KW_EFF));
+	*print_effective = ((mode != KW_NONE) && (mode != KW_FULL));
+	if(*print_full) {
+		*full_kw = ver->get_full_keywords();
+	}
+	if(*print_effective) {
+		*eff_kw = ver->get_effective_keywords();
+	}
+	if((mode == KW_FULLS) || (mode == KW_EFFS)) {
+		if(likely(*full_kw == *eff_kw)) {
+			if(mode == KW_FULLS) {
+				*print_effective = false;
+			} else {
+				*print_full = false;
+			}
+		}
+	}
+}
+
+void PrintXml::get_mask_texts(WordVec *mask_text, WordVec *unmask_text, const SetStability *stability, const Version *ver, Package *pkg) {
+	MaskFlags currmask(ver->maskflags);
+	KeywordsFlags currkey(ver->keyflags);
+	MaskFlags wasmask;
+	KeywordsFlags waskey;
+	stability->calc_version_flags(false, &wasmask, &waskey, ver, pkg);
+
+	// The following might give a memory leak with -flto for unknown reasons:
+	// mask_text->PUSH_BACK("FOO") or mask_text->PUSH_BACK("BAR")
+	if(wasmask.isHardMasked()) {
+		if(currmask.isProfileMask()) {
+			mask_text->push_back("profile");
+		} else if(currmask.isPackageMask()) {
+			mask_text->push_back("hard");
+		} else if(wasmask.isProfileMask()) {
+			mask_text->push_back("profile");
+			unmask_text->push_back("package_unmask");
+		} else {
+			mask_text->push_back("hard");
+			unmask_text->push_back("package_unmask");
+		}
+	} else if(currmask.isHardMasked()) {
+		mask_text->push_back("package_mask");
+	}
+
+	if(currkey.isStable()) {
+		if(waskey.isStable()) {
+			//
+		} else if(waskey.isUnstable()) {
+			mask_text->push_back("keyword");
+			unmask_text->push_back("package_keywords");
+		} else if(waskey.isMinusKeyword()) {
+			mask_text->push_back("minus_keyword");
+			unmask_text->push_back("package_keywords");
+		} else if(waskey.isAlienStable()) {
+			mask_text->push_back("alien_stable");
+			unmask_text->push_back("package_keywords");
+		} else if(waskey.isAlienUnstable()) {
+			mask_text->push_back("alien_unstable");
+			unmask_text->push_back("package_keywords");
+		} else if(waskey.isMinusUnstable()) {
+			mask_text->push_back("minus_unstable");
+			unmask_text->push_back("package_keywords");
+		} else if(waskey.isMinusAsterisk()) {
+			mask_text->push_back("minus_asterisk");
+			unmask_text->push_back("package_keywords");
+		} else {
+			mask_text->push_back("missing_keyword");
+			unmask_text->push_back("package_keywords");
+		}
+	} else if(currkey.isUnstable()) {
+		mask_text->push_back("keyword");
+	} else if(currkey.isMinusKeyword()) {
+		mask_text->push_back("minus_keyword");
+	} else if(currkey.isAlienStable()) {
+		mask_text->push_back("alien_stable");
+	} else if(currkey.isAlienUnstable()) {
+		mask_text->push_back("alien_unstable");
+	} else if(currkey.isMinusUnstable()) {
+		mask_text->push_back("minus_unstable");
+	} else if(currkey.isMinusAsterisk()) {
+		mask_text->push_back("minus_asterisk");
+	} else {
+		mask_text->push_back("missing_keyword");
+	}
+}
+
+void PrintXml::append_xmlstring(string *dest, bool quoted, const string& s) {
+	const char *reject(quoted ? "&<>'\"" : "&<>");
+	const char *str(s.c_str());
+	string::size_type len(s.size());
+	string::size_type i(0);
+	for(;;) {
+		// Clean runs are copied wholesale; strcspn() stops also at '\0'
+		string::size_type clean(std::strcspn(str + i, reject));
+		dest->append(str + i, clean);
+		i += clean;
+		if(likely(i >= len)) {
+			return;
+		}
+		switch(str[i]) {
 			case '&':
-				replace = "&amp;";
+				dest->append("&amp;");
 				break;
 			case '<':
-				replace = "&lt;";
+				dest->append("&lt;");
 				break;
 			case '>':
-				replace = "&gt;";
+				dest->append("&gt;");
 				break;
 			case '\'':
-				replace = (quoted ? "&apos;" : NULLPTR);
+				dest->append("&apos;");
 				break;
 			case '\"':
-				replace = (quoted ? "&quot;" : NULLPTR);
+				dest->append("&quot;");
 				break;
 			default:
-				replace = NULLPTR;
+				dest->append(1, '\0');
 				break;
 		}
-		if(unlikely(replace != NULLPTR)) {
-			ret.append(s, prev, i - prev);
-			ret.append(replace);
-			prev = i + 1;
-		}
-	}
-	if(likely(prev == 0)) {
-		return s;
-	}
-	if(prev < len) {
-		ret.append(s, prev, len - prev);
+		++i;
 	}
-	return ret;
 }
 
-void PrintXml::say_xml_element(const string& prefix, const string& name, const string& content) {
+void PrintXml::append_xml_element(string *dest, const char *prefix, const char *name, const string& content) {
 	if(unlikely(content.empty())) {
-		eix::say("%s<%s/>") % prefix % name;
+		dest->append(prefix);
+		dest->append(1, '<');
+		dest->append(name);
+		dest->append("/>\n");
 		return;
 	}
-	eix::say("%s<%s>%s</%2$s>") % prefix % name
-		% escape_xmlstring(false, content);
+	append_element(dest, prefix, name, content);
 }
@@ -19,7 +19,10 @@
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_container.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/unordered_set.h"
 #include "output/print-formats.h"
+#include "portage/extendedversion.h"
 #include "portage/package.h"
 
 class EixRc;
@@ -27,12 +30,17 @@ class DBHeader;
 class VarDbPkg;
 class PrintFormat;
 class SetStability;
+class Version;
 
 class PrintXml FINAL : public PrintFormats {
+	public:
+		enum KeywordsMode { KW_NONE, KW_BOTH, KW_FULL, KW_EFF, KW_FULLS, KW_EFFS };
+		typedef UNORDERED_SET<const Version *> InstalledVersions;
+
 	protected:
 		bool started;
 		bool print_overlay;
-		enum { KW_NONE, KW_BOTH, KW_FULL, KW_EFF, KW_FULLS, KW_EFFS } keywords_mode;
+		KeywordsMode keywords_mode;
 
 		const DBHeader *hdr;
 		VarDbPkg *var_db_pkg;
@@ -69,11 +77,54 @@ class PrintXml FINAL : public PrintFormats {
 			clear(NULLPTR);
 		}
 
+		/**
+		@return the mode chosen by XML_KEYWORDS
+		**/
+		ATTRIBUTE_NONNULL_ static KeywordsMode get_keywords_mode(EixRc *eixrc);
+
+		/**
+		Get the reasons why ver is masked and the files which unmask it
+		**/
+		ATTRIBUTE_NONNULL_ static void get_mask_texts(WordVec *mask_text, WordVec *unmask_text, const SetStability *stability, const Version *ver, Package *pkg);
+
+		/**
+		Get the versions of pkg which are output as installed:
+		Those installed from the correct overlay and for each remaining
+		installed version the last one with this version number
+		**/
+		ATTRIBUTE_NONNULL((1, 2)) static void get_installed(InstalledVersions *have_inst, Package *pkg, VarDbPkg *vardb, const DBHeader *header);
+
+		/**
+		Get the names of the RESTRICT flags
+		**/
+		ATTRIBUTE_NONNULL_ static void get_restrict_names(WordVec *names, ExtendedVersion::Restrict restrict);
+
+		/**
+		Get the names of the PROPERTIES flags
+		**/
+		ATTRIBUTE_NONNULL_ static void get_properties_names(WordVec *names, ExtendedVersion::Properties properties);
+
+		/**
+		Get the full and effective keywords of ver which are output in mode
+		@param print_full is set if full_kw is to be output
+		@param print_effective is set if eff_kw is to be output
+		**/
+		ATTRIBUTE_NONNULL_ static void get_keywords(bool *print_full, bool *print_effective, std::string *full_kw, std::string *eff_kw, KeywordsMode mode, const Version *ver);
+
 		void start() OVERRIDE;
 		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
 		void finish() OVERRIDE;
-		static std::string escape_xmlstring(bool quoted, const std::string& s);
-		static void say_xml_element(const std::string& prefix, const std::string& name, const std::string& content);
+
+		/**
+		Append s to dest, escaped for XML; quoted if used in an attribute
+		**/
+		ATTRIBUTE_NONNULL_ static void append_xmlstring(std::string *dest, bool quoted, const std::string& s);
+
+		/**
+		Append an element with prefix and a final newline to dest;
+		use the empty form <name/> if content is empty
+		**/
+		ATTRIBUTE_NONNULL_ static void append_xml_element(std::string *dest, const char *prefix, const char *name, const std::string& content);
 
 		~PrintXml() {
 			finish();
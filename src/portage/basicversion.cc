@@ -10,8 +10,6 @@
 #include "portage/basicversion.h"
 #include <config.h>  // IWYU pragma: keep
 
-#include <algorithm>
-#include <iterator>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -33,7 +31,7 @@ using std::stringstream;
 const string::size_type BasicPart::max_type;
 
 bool BasicPart::equal_but_right_is_cut(const BasicPart& left, const BasicPart& right) {
-	return ((left.parttype == right.parttype) && right.partcontent.empty());
+	return ((left.parttype == right.parttype) && (right.partsize == 0));
 }
 
 eix::SignedBool BasicPart::compare(const BasicPart& left, const BasicPart& right) {
@@ -51,8 +49,10 @@ eix::SignedBool BasicPart::compare(const BasicPart& left, const BasicPart& right
 	We can short-circuit numeric_compare(..) and cutting of trailing 0
 	by using string comparison if both parts have the same length.
 	*/
-	if(left.partcontent.size() == right.partcontent.size()) {
-		return eix::toSignedBool(left.partcontent.compare(right.partcontent));
+	string left_content(left.content());
+	string right_content(right.content());
+	if(left_content.size() == right_content.size()) {
+		return eix::toSignedBool(left_content.compare(right_content));
 	}
 	if(left.parttype == BasicPart::primary) {
 		/*
@@ -62,12 +62,9 @@ eix::SignedBool BasicPart::compare(const BasicPart& left, const BasicPart& right
 		stringwise comparison."
 		*/
 
-		if(((left.partcontent)[0] == '0') || ((right.partcontent)[0] == '0')) {
-			string l1(left.partcontent);
-			string l2(right.partcontent);
-
-			rtrim(&l1, "0");
-			rtrim(&l2, "0");
+		if((left_content[0] == '0') || (right_content[0] == '0')) {
+			rtrim(&left_content, "0");
+			rtrim(&right_content, "0");
 
 			/*
 			No need to check if stripping zeros makes the component empty,
@@ -76,7 +73,7 @@ eix::SignedBool BasicPart::compare(const BasicPart& left, const BasicPart& right
 			other possible value is bigger.
 			*/
 
-			return eix::toSignedBool(l1.compare(l2));
+			return eix::toSignedBool(left_content.compare(right_content));
 		}
 		/*
 		"If neither component has a leading zero, components are compared
@@ -84,14 +81,14 @@ eix::SignedBool BasicPart::compare(const BasicPart& left, const BasicPart& right
 		*/
 	} else if(left.parttype == BasicPart::garbage) {
 		// garbage gets string comparison.
-		return eix::toSignedBool(left.partcontent.compare(left.partcontent));
+		return eix::toSignedBool(left_content.compare(left_content));
 	}
 
 	/*
 	"The first component of the number part is compared using strict integer
 	comparison."
 	*/
-	return eix::numeric_compare(left.partcontent, right.partcontent);
+	return eix::numeric_compare(left_content, right_content);
 }
 
 static ostream& operator<<(ostream& s, const BasicPart& part) {
@@ -99,40 +96,82 @@ static ostream& operator<<(ostream& s, const BasicPart& part) {
 		case BasicPart::first:
 		case BasicPart::character:
 		case BasicPart::garbage:
-			return s << part.partcontent;
+			break;
 		case BasicPart::alpha:
-			return s << "_alpha" << part.partcontent;
+			s << "_alpha";
+			break;
 		case BasicPart::beta:
-			return s << "_beta" << part.partcontent;
+			s << "_beta";
+			break;
 		case BasicPart::pre:
-			return s << "_pre" << part.partcontent;
+			s << "_pre";
+			break;
 		case BasicPart::rc:
-			return s << "_rc" << part.partcontent;
+			s << "_rc";
+			break;
 		case BasicPart::patch:
-			return s << "_p" << part.partcontent;
+			s << "_p";
+			break;
 		case BasicPart::revision:
-			return s << "-r" << part.partcontent;
+			s << "-r";
+			break;
 		case BasicPart::inter_rev:
 		case BasicPart::primary:
-			return s << "." << part.partcontent;
+			s << ".";
+			break;
 		default:
+			eix::say_error(_("internal error: unknown PartType on (\"%s\",\"%s\")"))
+				% static_cast<int>(part.parttype) % part.content();
+			return s;
+	}
+	return s.write(part.partcontent, part.partsize);
+}
+
+void BasicVersion::PartIterator::decode() {
+	if(unlikely(m_pos == m_buffer->size())) {
+		return;
+	}
+	string::size_type num(0);
+	string::size_type pos(m_pos);
+	for(unsigned int shift(0); ; shift += 7) {
+		unsigned char c(static_cast<unsigned char>((*m_buffer)[pos++]));
+		num |= static_cast<string::size_type>(c & 0x7F) << shift;
+		if(likely((c & 0x80) == 0)) {
 			break;
+		}
+	}
+	m_part.parttype = BasicPart::PartType(num % BasicPart::max_type);
+	m_part.partsize = num / BasicPart::max_type;
+	m_part.partcontent = m_buffer->c_str() + pos;
+	m_next = pos + m_part.partsize;
+}
+
+void BasicVersion::add_part_header(string::size_type num) {
+	for(; num >= 0x80; num >>= 7) {
+		m_parts.append(1, static_cast<char>((num & 0x7F) | 0x80));
 	}
-	eix::say_error(_("internal error: unknown PartType on (\"%s\",\"%s\")"))
-		% static_cast<int>(part.parttype) % part.partcontent;
-	return s;
+	m_parts.append(1, static_cast<char>(num));
+}
+
+void BasicVersion::add_part(BasicPart::PartType type, const string& s, string::size_type start, string::size_type len) {
+	if((len == string::npos) || (start + len > s.size())) {
+		len = s.size() - start;
+	}
+	add_part_header(len * BasicPart::max_type + type);
+	m_parts.append(s, start, len);
 }
 
 string BasicVersion::getFull() const {
 	stringstream ss;
-	copy(m_parts.begin(), m_parts.end(), std::ostream_iterator<BasicPart>(ss));
+	for(PartIterator it(m_parts); likely(!it.at_end()); ++it) {
+		ss << *it;
+	}
 	return ss.str();
 }
 
 string BasicVersion::getPlain() const {
 	stringstream ss;
-	for(PartsType::const_iterator it(m_parts.begin());
-		likely(it != m_parts.end()); ++it) {
+	for(PartIterator it(m_parts); likely(!it.at_end()); ++it) {
 		if(unlikely(it->parttype == BasicPart::revision)) {
 			break;
 		}
@@ -143,12 +182,12 @@ string BasicVersion::getPlain() const {
 
 string BasicVersion::getRevision() const {
 	stringstream ss;
-	for(PartsType::const_iterator it(m_parts.begin());
-		likely(it != m_parts.end()); ++it) {
+	for(PartIterator it(m_parts); likely(!it.at_end()); ++it) {
 		if(unlikely(it->parttype == BasicPart::revision)) {
-			ss << "r" << it->partcontent;
-			if(unlikely(++it != m_parts.end())) {
-				copy(it, m_parts.end(), std::ostream_iterator<BasicPart>(ss));
+			ss << "r";
+			ss.write(it->partcontent, it->partsize);
+			while(!(++it).at_end()) {
+				ss << *it;
 			}
 			break;
 		}
@@ -156,12 +195,88 @@ string BasicVersion::getRevision() const {
 	return ss.str();
 }
 
+/**
+Components longer than this are not encoded into m_key
+**/
+static CONSTEXPR const string::size_type max_key_digits = 127;
+
+void BasicVersion::calc_key() {
+	m_key.clear();
+	m_key_plain = string::npos;
+	m_key_prefix = 0;
+	bool cut(false);
+	for(PartIterator it(m_parts); likely(!it.at_end()); ++it) {
+		BasicPart::PartType type(it->parttype);
+		const char *content(it->partcontent);
+		string::size_type size(it->partsize);
+		if(unlikely(type == BasicPart::garbage)) {
+			m_key.clear();
+			return;
+		}
+		if(unlikely(type == BasicPart::revision) && (m_key_plain == string::npos)) {
+			m_key_plain = m_key.size();
+		}
+		m_key.append(1, static_cast<char>(2 * type + 1));
+		m_key_prefix = m_key.size();
+		cut = (size == 0);
+		if(type == BasicPart::character) {
+			if(unlikely(size != 1)) {
+				m_key.clear();
+				return;
+			}
+			m_key.append(1, *content);
+			continue;
+		}
+		if(type == BasicPart::primary) {
+			// A leading zero means stringwise comparison without trailing
+			// zeros; such components are smaller than all others.
+			if(likely(size != 0) && (*content == '0')) {
+				m_key.append(1, '\1');
+				string::size_type end(size);
+				while((end != 0) && (content[end - 1] == '0')) {
+					--end;
+				}
+				m_key.append(content, end);
+				m_key.append(1, '\0');
+				continue;
+			}
+			m_key.append(1, '\2');
+		}
+		// Numeric comparison: length of the number without leading zeros
+		string::size_type start(0);
+		while((start != size) && (content[start] == '0')) {
+			++start;
+		}
+		string::size_type len(size - start);
+		if(unlikely(len > max_key_digits)) {
+			m_key.clear();
+			return;
+		}
+		m_key.append(1, static_cast<char>(len));
+		m_key.append(content + start, len);
+	}
+	if(m_key_plain == string::npos) {
+		m_key_plain = m_key.size();
+	}
+	// alpha2 must match alpha if right_maybe_shorter
+	if(!cut) {
+		m_key_prefix = m_key.size();
+	}
+	m_key.append(1, static_cast<char>(2 * BasicPart::revision));
+}
+
 BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *errtext, eix::SignedBool accept_garbage) {
+	BasicVersion::ParseResult r(parseParts(str, errtext, accept_garbage));
+	calc_key();
+	return r;
+}
+
+BasicVersion::ParseResult BasicVersion::parseParts(const string& str, string *errtext, eix::SignedBool accept_garbage) {
 	m_parts.clear();
 	string::size_type pos(0);
 	string::size_type endpos(str.find_first_not_of("0123456789", pos));
 	if(unlikely((endpos == pos) || (pos == str.size()))) {
-		m_parts.EMPLACE_BACK(BasicPart, (BasicPart::garbage, str, pos));
+		add_part(BasicPart::garbage, str, pos);
 		if(errtext != NULLPTR) {
 			*errtext = eix::format(_(
 			"malformed (first primary at position %s) version string \"%s\""))
@@ -169,7 +284,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 		}
 		return parsedError;
 	}
-	m_parts.EMPLACE_BACK(BasicPart, (BasicPart::first, str, pos, endpos - pos));
+	add_part(BasicPart::first, str, pos, endpos - pos);
 
 	if(endpos == string::npos) {
 		return parsedOK;
@@ -180,7 +295,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 	while(str[pos] == '.') {
 		endpos = str.find_first_not_of("0123456789", ++pos);
 		if(unlikely((endpos == pos) || (pos == str.size()))) {
-			m_parts.EMPLACE_BACK(BasicPart, (BasicPart::garbage, str, pos));
+			add_part(BasicPart::garbage, str, pos);
 			if(errtext != NULLPTR) {
 				*errtext = eix::format(_(
 				"malformed (primary at position %s) version string \"%s\""))
@@ -188,7 +303,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 			}
 			return parsedError;
 		}
-		m_parts.EMPLACE_BACK(BasicPart, (BasicPart::primary, str, pos, endpos - pos));
+		add_part(BasicPart::primary, str, pos, endpos - pos);
 
 		if(endpos == string::npos) {
 			return parsedOK;
@@ -198,7 +313,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 	}
 
 	if(my_isalpha(str[pos])) {
-		m_parts.EMPLACE_BACK(BasicPart, (BasicPart::character, str[pos++]));
+		add_part(BasicPart::character, str, pos++, 1);
 	}
 
 	if(pos == str.size()) {
@@ -224,7 +339,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 			++pos;
 			suffix = BasicPart::patch;
 		} else {
-			m_parts.EMPLACE_BACK(BasicPart, (BasicPart::garbage, str, pos-1));
+			add_part(BasicPart::garbage, str, pos-1);
 			if(errtext != NULLPTR) {
 				*errtext = eix::format(_(
 				"malformed (suffix at position %s) version string \"%s\""))
@@ -234,7 +349,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 		}
 
 		endpos = str.find_first_not_of("0123456789", pos);
-		m_parts.EMPLACE_BACK(BasicPart, (suffix, str, pos, endpos - pos));
+		add_part(suffix, str, pos, endpos - pos);
 
 		if(endpos == string::npos) {
 			return parsedOK;
@@ -246,7 +361,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 	// get optional gentoo revision
 	if(str.compare(pos, 2, "-r") == 0) {
 		endpos = str.find_first_not_of("0123456789", pos+=2);
-		m_parts.EMPLACE_BACK(BasicPart, (BasicPart::revision, str, pos, endpos - pos));
+		add_part(BasicPart::revision, str, pos, endpos - pos);
 
 		if(endpos == string::npos) {
 			return parsedOK;
@@ -257,7 +372,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 			// inter-revision used by prefixed portage.
 			// for example foo-1.2-r02.2
 			endpos = str.find_first_not_of("0123456789", ++pos);
-			m_parts.EMPLACE_BACK(BasicPart, (BasicPart::inter_rev, str, pos, endpos - pos));
+			add_part(BasicPart::inter_rev, str, pos, endpos - pos);
 			if(endpos == string::npos)
 				return parsedOK;
 			pos = endpos;
@@ -265,7 +380,7 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 	}
 
 	if(accept_garbage >= 0) {
-		m_parts.EMPLACE_BACK(BasicPart, (BasicPart::garbage, str, pos));
+		add_part(BasicPart::garbage, str, pos);
 	}
 	if(errtext != NULLPTR) {
 		*errtext = eix::format(accept_garbage ?
@@ -278,14 +393,24 @@ BasicVersion::ParseResult BasicVersion::parseVersion(const string& str, string *
 }
 
 eix::SignedBool BasicVersion::compare(const BasicVersion& left, const BasicVersion& right, bool right_maybe_shorter) {
-	for(PartsType::const_iterator it_left(left.m_parts.begin()),
-		it_right(right.m_parts.begin()); ; ++it_left) {
-		if(it_left == left.m_parts.end()) {
-			if(it_right == right.m_parts.end()) {
+	if(unlikely(left.m_key.empty() || right.m_key.empty())) {
+		return compare_parts(left, right, right_maybe_shorter);
+	}
+	if(unlikely(right_maybe_shorter) &&
+		(left.m_key.compare(0, right.m_key_prefix, right.m_key, 0, right.m_key_prefix) == 0)) {
+		return 0;
+	}
+	return eix::toSignedBool(left.m_key.compare(right.m_key));
+}
+
+eix::SignedBool BasicVersion::compare_parts(const BasicVersion& left, const BasicVersion& right, bool right_maybe_shorter) {
+	for(PartIterator it_left(left.m_parts), it_right(right.m_parts); ; ++it_left) {
+		if(it_left.at_end()) {
+			if(it_right.at_end()) {
 				break;
 			}
 			return ((it_right->parttype < BasicPart::revision) ? 1 : -1);
-		} else if(it_right == right.m_parts.end()) {
+		} else if(it_right.at_end()) {
 			if(unlikely(right_maybe_shorter)) {
 				break;
 			}
@@ -295,8 +420,9 @@ eix::SignedBool BasicVersion::compare(const BasicVersion& left, const BasicVersi
 		if(ret != 0) {
 			// alpha2 must match alpha if right_maybe_shorter
 			if(unlikely(right_maybe_shorter)) {
-				if(unlikely(++it_right == right.m_parts.end())) {
-					if(BasicPart::equal_but_right_is_cut(*it_left, right.m_parts.back())) {
+				BasicPart last(*it_right);
+				if(unlikely((++it_right).at_end())) {
+					if(BasicPart::equal_but_right_is_cut(*it_left, last)) {
 						return 0;
 					}
 				}
@@ -310,11 +436,13 @@ eix::SignedBool BasicVersion::compare(const BasicVersion& left, const BasicVersi
 }
 
 eix::SignedBool BasicVersion::compareTilde(const BasicVersion& left, const BasicVersion& right) {
-	for(PartsType::const_iterator it_left(left.m_parts.begin()),
-		it_right(right.m_parts.begin()); ; ++it_left, ++it_right) {
-		bool right_end((it_right == right.m_parts.end())
+	if(likely(!left.m_key.empty() && !right.m_key.empty())) {
+		return eix::toSignedBool(left.m_key.compare(0, left.m_key_plain, right.m_key, 0, right.m_key_plain));
+	}
+	for(PartIterator it_left(left.m_parts), it_right(right.m_parts); ; ++it_left, ++it_right) {
+		bool right_end(it_right.at_end()
 				|| (it_right->parttype == BasicPart::revision));
-		if((it_left == left.m_parts.end())
+		if(it_left.at_end()
 				|| (it_left->parttype == BasicPart::revision)) {
 			return (right_end ? 0 : -1);
 		} else if(right_end) {
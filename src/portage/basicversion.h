@@ -13,7 +13,6 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
-#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
@@ -24,6 +23,10 @@ class Database;
 
 // check_includes: include "portage/basicversion.h"
 
+/**
+A part of a BasicVersion. The content belongs to the version
+and is not 0-terminated.
+**/
 class BasicPart {
 	public:
 		enum PartType {
@@ -43,29 +46,17 @@ class BasicPart {
 		// This must be larger than PartType elements and should be a power of 2.
 		static CONSTEXPR const std::string::size_type max_type = 32;
 		PartType parttype;
-		std::string partcontent;
-
-		BasicPart() {
-		}
+		const char *partcontent;
+		std::string::size_type partsize;
 
-		explicit BasicPart(PartType p) : parttype(p), partcontent() {
+		BasicPart() : parttype(garbage), partcontent(""), partsize(0) {
 		}
 
-		BasicPart(PartType p, const std::string& s) : parttype(p), partcontent(s) {
+		BasicPart(PartType p, const char *s, std::string::size_type len) : parttype(p), partcontent(s), partsize(len) {
 		}
 
-		BasicPart(PartType p, const std::string& s, std::string::size_type start)
-			: parttype(p), partcontent(s, start) {
-		}
-
-		BasicPart(PartType p, const std::string& s, std::string::size_type start, std::string::size_type end)
-			: parttype(p), partcontent(s, start, end) {
-		}
-
-		BasicPart(PartType p, char c) : parttype(p), partcontent(1, c) {
-		}
-
-		ATTRIBUTE_NONNULL_ BasicPart(PartType p, const char *s) : parttype(p), partcontent(s) {
+		std::string content() const {
+			return std::string(partcontent, partsize);
 		}
 
 		ATTRIBUTE_PURE static eix::SignedBool compare(const BasicPart& left, const BasicPart& right);
@@ -80,18 +71,29 @@ Parse and represent a portage version-string.
 class BasicVersion {
 		friend class Database;
 
+	public:
+		enum ParseResult {
+			parsedOK,
+			parsedError,
+			parsedGarbage
+		};
+
 	private:
 		/**
 		Compare the version
 		**/
 		ATTRIBUTE_PURE static eix::SignedBool compare(const BasicVersion& right, const BasicVersion& left, bool right_maybe_shorter);
 
+		/**
+		Compare the version part by part; used if there is no m_key
+		**/
+		ATTRIBUTE_PURE static eix::SignedBool compare_parts(const BasicVersion& left, const BasicVersion& right, bool right_maybe_shorter);
+
+		BasicVersion::ParseResult parseParts(const std::string& str, std::string *errtext, eix::SignedBool accept_garbage);
+
 	public:
-		enum ParseResult {
-			parsedOK,
-			parsedError,
-			parsedGarbage
-		};
+		BasicVersion() : m_key_plain(0), m_key_prefix(0) {
+		}
 
 WSUGGEST_FINAL_METHODS_OFF
 		virtual ~BasicVersion() { }
@@ -136,10 +138,80 @@ WSUGGEST_FINAL_METHODS_ON
 
 	protected:
 		/**
-		Splitted m_primsplit-version
+		All parts of the version in one buffer. Each part is stored as the
+		number size * BasicPart::max_type + type (7 bits per byte, the high
+		bit meaning that more bytes follow), followed by the content.
+		**/
+		std::string m_parts;
+
+		/**
+		Iterate through the parts stored in m_parts
+		**/
+		class PartIterator {
+			private:
+				const std::string *m_buffer;
+				std::string::size_type m_pos, m_next;
+				BasicPart m_part;
+
+				void decode();
+
+			public:
+				explicit PartIterator(const std::string& buffer) : m_buffer(&buffer), m_pos(0) {
+					decode();
+				}
+
+				bool at_end() const {
+					return (m_pos == m_buffer->size());
+				}
+
+				const BasicPart& operator*() const {
+					return m_part;
+				}
+
+				const BasicPart *operator->() const {
+					return &m_part;
+				}
+
+				PartIterator& operator++() {
+					m_pos = m_next;
+					decode();
+					return *this;
+				}
+		};
+
+		/**
+		Append the header of a part to m_parts; the content must follow
+		**/
+		void add_part_header(std::string::size_type num);
+
+		void add_part(BasicPart::PartType type, const std::string& s, std::string::size_type start, std::string::size_type len);
+
+		void add_part(BasicPart::PartType type, const std::string& s, std::string::size_type start) {
+			add_part(type, s, start, std::string::npos);
+		}
+
+		/**
+		m_parts encoded such that the version order is the string order.
+		Each part is its type followed by its normalized content;
+		the end marker sorts between rc and revision.
+		Empty if the version cannot be encoded (e.g. due to garbage).
+		**/
+		std::string m_key;
+
+		/**
+		Length of m_key up to the revision; for compareTilde
+		**/
+		std::string::size_type m_key_plain;
+
+		/**
+		Length of m_key which must be a prefix for compare_right_maybe_shorter
+		**/
+		std::string::size_type m_key_prefix;
+
+		/**
+		Calculate m_key from m_parts
 		**/
-		typedef std::vector<BasicPart> PartsType;
-		PartsType m_parts;
+		void calc_key();
 };
 
 
@@ -29,6 +29,7 @@
 #include "eixTk/unordered_map.h"
 #include "eixTk/utils.h"
 #include "portage/conf/portagesettings.h"
+#include "portage/conf/profilecache.h"
 #include "portage/mask.h"
 #include "portage/mask_list.h"
 
@@ -51,8 +52,12 @@ Add all files from profile and its parents to m_profile_files
 **/
 bool CascadingProfile::addProfile(const char *profile, WordUnorderedSet *sourced_files) {
 	string truename(normalize_path(profile, true, true));
-	if(unlikely(print_profile_paths)) {
-		if(likely(is_dir(truename.c_str()))) {
+	if(m_cache != NULLPTR) {
+		m_cache->add_path(profile, false);
+	}
+	if(likely(is_dir(truename.c_str()))) {
+		m_portagesettings->profile_dirs.PUSH_BACK(truename);
+		if(unlikely(print_profile_paths)) {
 			eix::print() % truename;
 			if(profile_paths_append.empty()) {
 				eix::print('\0');
@@ -75,6 +80,10 @@ bool CascadingProfile::addProfile(const char *profile, WordUnorderedSet *sourced
 	WordVec parents;
 	string currfile(truename);
 	currfile.append("parent");
+	if(m_cache != NULLPTR) {
+		m_cache->add_path(truename, false);
+		m_cache->add_path(currfile, false);
+	}
 	// Use pushback_lines to avoid keeping file descriptor open:
 	// Who knows what's our limit of open file descriptors.
 	if(pushback_lines(currfile.c_str(), &parents)) {
@@ -178,6 +187,13 @@ bool CascadingProfile::readremoveFiles() {
 			continue;
 		}
 		OverlayIdent& overlay(m_portagesettings->repos[file->repo_num()]);
+		if(m_cache != NULLPTR) {
+			m_cache->add_path(file->name(), true);
+			if(overlay.know_path && !overlay.know_label) {
+				m_cache->add_path(overlay.path + "/metadata/layout.conf", false);
+				m_cache->add_path(overlay.path + "/profiles/repo_name", false);
+			}
+		}
 		overlay.readLabel();
 		if((this->*handler)(file->name(),
 			(overlay.label.empty() ? NULLPTR : overlay.label.c_str()),
@@ -257,6 +273,9 @@ Read all "make.defaults" files found in profile
 void CascadingProfile::readMakeDefaults() {
 	for(WordVec::size_type i(0); likely(i < m_profile_files.size()); ++i) {
 		if(unlikely(std::strcmp(std::strrchr(m_profile_files[i].c_str(), '/'), "/make.defaults") == 0)) {
+			if(m_cache != NULLPTR) {
+				m_cache->add_path(m_profile_files[i].name(), false);
+			}
 			m_portagesettings->read_config(m_profile_files[i].name(), "");
 		}
 	}
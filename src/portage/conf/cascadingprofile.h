@@ -25,6 +25,7 @@
 
 class Package;
 class PortageSettings;
+class ProfileCache;
 class ProfileFilenames;
 
 class ProfileFile {
@@ -59,12 +60,14 @@ class ProfileFile {
 Access to the cascading profile pointed to by /etc/make.profile
 **/
 class CascadingProfile {
+		friend class ProfileCache;
 		friend class ProfileFilenames;
 	public:
 		bool print_profile_paths;
 		std::string profile_paths_append;
 		bool use_world, finalized;
 		MaskList<Mask> m_world;            ///< Packages in world. This must be set externally
+		ProfileCache *m_cache;             ///< If nonzero, all files read are recorded there
 
 	protected:
 		bool m_init_world;
@@ -134,6 +137,7 @@ class CascadingProfile {
 		ATTRIBUTE_NONNULL_ CascadingProfile(PortageSettings *portagesettings, bool init_world) :
 			print_profile_paths(false),
 			use_world(false), finalized(false),
+			m_cache(NULLPTR),
 			m_init_world(init_world),
 			m_portagesettings(portagesettings) {
 		}
@@ -37,6 +37,7 @@
 #include "eixrc/eixrc.h"
 #include "portage/basicversion.h"
 #include "portage/conf/cascadingprofile.h"
+#include "portage/conf/profilecache.h"
 #include "portage/keywords.h"
 #include "portage/mask.h"
 #include "portage/mask_list.h"
@@ -388,33 +389,49 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 		read_world_sets((*eixrc)["EIX_WORLD_SETS"].c_str());
 	}
 
-	string& my_path((*this)["PORTDIR"]);
-	profile->listaddFile(my_path + PORTDIR_MASK_FILE, 0, false);
-	profile->listaddFile(my_path + PORTDIR_UNMASK_FILE, 0, false);
-	profile->listaddProfile();
-	if(unlikely(print_profile_paths)) {
-		return;
-	}
-	profile->readMakeDefaults();
-	profile->readremoveFiles();
 	CascadingProfile *local_profile(NULLPTR);
-	if(getlocal) {
-		local_profile = new CascadingProfile(*profile);
-	}
-	addOverlayProfiles(profile);
-	if(getlocal) {
-		local_profile->listaddProfile((m_eprefixconf + USER_PROFILE_DIR).c_str());
-		addOverlayProfiles(local_profile);
-		local_profile->readMakeDefaults();
-		if(!local_profile->readremoveFiles()) {
-			// local_profile does not differ; we do not need it
-			delete local_profile;
-			local_profile = NULLPTR;
+	ProfileCache *profile_cache(NULLPTR);
+	const string& profile_cache_file((*eixrc)["EIX_PROFILE_CACHE"]);
+	if(likely(!print_profile_paths) && unlikely(!profile_cache_file.empty())) {
+		profile_cache = new ProfileCache(profile_cache_file, *this, getlocal);
+	}
+	if((profile_cache == NULLPTR) || !profile_cache->load(this, profile, &local_profile)) {
+		profile->m_cache = profile_cache;
+		string& my_path((*this)["PORTDIR"]);
+		profile->listaddFile(my_path + PORTDIR_MASK_FILE, 0, false);
+		profile->listaddFile(my_path + PORTDIR_UNMASK_FILE, 0, false);
+		profile->listaddProfile();
+		if(unlikely(print_profile_paths)) {
+			return;
 		}
-	} else {
 		profile->readMakeDefaults();
+		profile->readremoveFiles();
+		if(getlocal) {
+			local_profile = new CascadingProfile(*profile);
+		}
+		addOverlayProfiles(profile);
+		if(getlocal) {
+			local_profile->listaddProfile((m_eprefixconf + USER_PROFILE_DIR).c_str());
+			addOverlayProfiles(local_profile);
+			local_profile->readMakeDefaults();
+			if(!local_profile->readremoveFiles()) {
+				// local_profile does not differ; we do not need it
+				delete local_profile;
+				local_profile = NULLPTR;
+			}
+		} else {
+			profile->readMakeDefaults();
+		}
+		profile->readremoveFiles();
+		profile->m_cache = NULLPTR;
+		if(local_profile != NULLPTR) {
+			local_profile->m_cache = NULLPTR;
+		}
+		if(profile_cache != NULLPTR) {
+			profile_cache->save(*this, *profile, local_profile);
+		}
 	}
-	profile->readremoveFiles();
+	delete profile_cache;
 	read_make_conf_late(eprefixsource);
 	override_by_env(test_in_env_late);
 
@@ -445,7 +462,10 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 		}
 	} else {
 		m_local_arch_set = m_auto_arch_set = &m_arch_set;
-	} {
+	}
+	m_accepted_keywords_flags.init(m_accepted_keywords_set);
+	m_auto_arch_flags.init(*m_auto_arch_set);
+	{
 		// Calculate m_raised_arch by prepending ~ to every token
 		WordSet archset;
 		for(WordSet::const_iterator it(m_arch_set.begin());
@@ -1128,7 +1148,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 		}
 		if(kv.size() == kvsize) {
 			// Nothing has changed. In this case, we take defaults:
-			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_set));
+			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_flags));
 			it->keyflags = kf;
 			it->save_keyflags(Version::SAVEKEY_ACCEPT);
 		} else {
@@ -1309,20 +1329,20 @@ void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Ve
 Set stability according to arch or local ACCEPT_KEYWORDS
 **/
 void PortageSettings::setKeyflags(Package *p, bool use_accepted_keywords) const {
-	const WordSet *accept_set;
+	const AcceptedKeywords *accept_flags;
 	Version::SavedKeyIndex ind;
 	if(use_accepted_keywords) {
 		ind = Version::SAVEKEY_ACCEPT;
-		accept_set = &m_accepted_keywords_set;
+		accept_flags = &m_accepted_keywords_flags;
 	} else {
 		ind = Version::SAVEKEY_ARCH;
-		accept_set = m_auto_arch_set;
+		accept_flags = &m_auto_arch_flags;
 	}
 	if(p->restore_keyflags(ind))
 		return;
 	get_effective_keywords_profile(p);
 	for(Package::iterator t(p->begin()); likely(t != p->end()); ++t) {
-		t->set_keyflags(*accept_set);
+		t->set_keyflags(*accept_flags);
 		t->save_keyflags(ind);
 	}
 }
@@ -171,6 +171,7 @@ class PortageSettings : public WordIterateMap {
 		WordSet                  m_accepted_keywords_set, m_arch_set,
 		                         m_plain_accepted_keywords_set,
 		                        *m_local_arch_set, *m_auto_arch_set;
+		AcceptedKeywords         m_accepted_keywords_flags, m_auto_arch_flags;
 		std::string              m_raised_arch;
 
 		MaskList<SetMask>        m_package_sets;
@@ -247,6 +248,11 @@ class PortageSettings : public WordIterateMap {
 		RepoList repos;
 		WordVec set_names;
 
+		/**
+		All directories which have been read as (parts of) profiles
+		**/
+		WordVec profile_dirs;
+
 #ifndef HAVE_SETENV
 		bool export_portdir_overlay;
 #endif
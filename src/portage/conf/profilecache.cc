@@ -0,0 +1,314 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "portage/conf/profilecache.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <ctime>
+
+#include <map>
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/utils.h"
+#include "portage/conf/cascadingprofile.h"
+#include "portage/conf/portagesettings.h"
+#include "portage/mask_list.h"
+#include "portage/overlay.h"
+
+using std::string;
+
+static CONSTEXPR const char profile_cache_magic[] = "eix-profile-cache 1";
+
+/**
+@return the stamp of path or "-" if it does not exist
+@param recent is set if path was changed within the last second
+**/
+static string get_stamp(const string& path, struct stat *st, bool *recent) {
+	if(stat(path.c_str(), st) != 0) {
+		return "-";
+	}
+	std::time_t now(std::time(NULLPTR));
+	if(unlikely((st->st_mtime + 1 >= now) || (st->st_ctime + 1 >= now))) {
+		*recent = true;
+	}
+	return eix::format("%s %s %s %s %s")
+		% st->st_dev % st->st_ino % st->st_size % st->st_mtime % st->st_ctime;
+}
+
+ProfileCache::ProfileCache(const string& filename, const PortageSettings& settings, bool getlocal) :
+	m_filename(filename), m_recent(false) {
+	m_key.PUSH_BACK(getlocal ? "local" : "");
+	m_key.PUSH_BACK(settings.m_eprefixconf);
+	m_key.PUSH_BACK(settings.m_eprefixaccessoverlays);
+	// The order of PortageSettings need not be deterministic
+	std::map<string, string> vars(settings.begin(), settings.end());
+	for(std::map<string, string>::const_iterator it(vars.begin());
+		likely(it != vars.end()); ++it) {
+		m_key.PUSH_BACK(it->first);
+		m_key.PUSH_BACK(it->second);
+	}
+	for(RepoList::const_iterator it(settings.repos.begin());
+		likely(it != settings.repos.end()); ++it) {
+		m_key.PUSH_BACK(eix::format("%s %s %s %s")
+			% (it->know_path ? 1 : 0) % (it->know_label ? 1 : 0)
+			% it->priority % (it->is_main ? 1 : 0));
+		m_key.PUSH_BACK(it->path);
+		m_key.PUSH_BACK(it->label);
+	}
+}
+
+void ProfileCache::add_path(const string& path, bool recursive) {
+	struct stat st;
+	string& stamp(m_stamps[path]);
+	stamp = get_stamp(path, &st, &m_recent);
+	if(!recursive || (stamp == "-") || !S_ISDIR(st.st_mode)) {
+		return;
+	}
+	WordVec files;
+	pushback_files(path + "/", &files, pushback_lines_exclude, 3);
+	for(WordVec::const_iterator it(files.begin()); likely(it != files.end()); ++it) {
+		add_path(*it, true);
+	}
+}
+
+bool ProfileCache::write_words(const WordVec& words) {
+	if(unlikely(!write_num(words.size(), NULLPTR))) {
+		return false;
+	}
+	for(WordVec::const_iterator it(words.begin()); likely(it != words.end()); ++it) {
+		if(unlikely(!write_string(*it, NULLPTR))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ProfileCache::read_words(WordVec *words) {
+	WordVec::size_type count;
+	if(unlikely(!read_num(&count, NULLPTR))) {
+		return false;
+	}
+	words->clear();
+	for(; count != 0; --count) {
+		string s;
+		if(unlikely(!read_string(&s, NULLPTR))) {
+			return false;
+		}
+		words->PUSH_BACK(MOVE(s));
+	}
+	return true;
+}
+
+bool ProfileCache::write_prelist(const PreList& l) {
+	if(unlikely(!write_num(l.filenames.size(), NULLPTR))) {
+		return false;
+	}
+	for(PreList::FileNames::const_iterator it(l.filenames.begin());
+		likely(it != l.filenames.end()); ++it) {
+		eix::UChar flags((it->know_repo ? 1 : 0) | (it->honour_repo ? 2 : 0));
+		if(unlikely(!write_string(it->filename, NULLPTR)) ||
+			unlikely(!write_string(it->m_repo, NULLPTR)) ||
+			unlikely(!writeUChar(flags, NULLPTR))) {
+			return false;
+		}
+	}
+	if(unlikely(!write_num(l.order.size(), NULLPTR))) {
+		return false;
+	}
+	for(PreList::Order::const_iterator it(l.order.begin());
+		likely(it != l.order.end()); ++it) {
+		eix::UChar flags((it->removed ? 1 : 0) | (it->locally_double ? 2 : 0));
+		if(unlikely(!write_words(*it)) ||
+			unlikely(!write_num(it->filename_index, NULLPTR)) ||
+			unlikely(!write_num(it->linenumber, NULLPTR)) ||
+			unlikely(!writeUChar(flags, NULLPTR))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ProfileCache::read_prelist(PreList *l) {
+	PreList::FileNames::size_type files;
+	if(unlikely(!read_num(&files, NULLPTR))) {
+		return false;
+	}
+	for(; files != 0; --files) {
+		string name, repo;
+		eix::UChar flags;
+		if(unlikely(!read_string(&name, NULLPTR)) ||
+			unlikely(!read_string(&repo, NULLPTR)) ||
+			unlikely(!readUChar(&flags, NULLPTR))) {
+			return false;
+		}
+		l->filenames.EMPLACE_BACK(PreListFilename, (name, (((flags & 1) != 0) ? repo.c_str() : NULLPTR), ((flags & 2) != 0)));
+	}
+	PreList::Order::size_type count;
+	if(unlikely(!read_num(&count, NULLPTR))) {
+		return false;
+	}
+	for(; count != 0; --count) {
+		WordVec line;
+		PreList::FilenameIndex file;
+		PreList::LineNumber number;
+		eix::UChar flags;
+		if(unlikely(!read_words(&line)) ||
+			unlikely(!read_num(&file, NULLPTR)) ||
+			unlikely(!read_num(&number, NULLPTR)) ||
+			unlikely(!readUChar(&flags, NULLPTR)) ||
+			unlikely(file >= l->filenames.size())) {
+			return false;
+		}
+		l->have[line] = l->order.size();
+		l->order.EMPLACE_BACK(PreListOrderEntry, (line, file, number));
+		PreListOrderEntry& e(l->order.back());
+		e.removed = ((flags & 1) != 0);
+		e.locally_double = ((flags & 2) != 0);
+	}
+	return true;
+}
+
+bool ProfileCache::write_prelists(const CascadingProfile& p) {
+	return (likely(write_prelist(p.p_system)) &&
+		likely(write_prelist(p.p_profile)) &&
+		likely(write_prelist(p.p_package_masks)) &&
+		likely(write_prelist(p.p_package_unmasks)) &&
+		likely(write_prelist(p.p_package_keywords)) &&
+		likely(write_prelist(p.p_package_accept_keywords)));
+}
+
+bool ProfileCache::read_prelists(CascadingProfile *p) {
+	return (likely(read_prelist(&(p->p_system))) &&
+		likely(read_prelist(&(p->p_profile))) &&
+		likely(read_prelist(&(p->p_package_masks))) &&
+		likely(read_prelist(&(p->p_package_unmasks))) &&
+		likely(read_prelist(&(p->p_package_keywords))) &&
+		likely(read_prelist(&(p->p_package_accept_keywords))));
+}
+
+void ProfileCache::copy_prelists(CascadingProfile *dest, const CascadingProfile& src) {
+	dest->p_system = src.p_system;
+	dest->p_profile = src.p_profile;
+	dest->p_package_masks = src.p_package_masks;
+	dest->p_package_unmasks = src.p_package_unmasks;
+	dest->p_package_keywords = src.p_package_keywords;
+	dest->p_package_accept_keywords = src.p_package_accept_keywords;
+}
+
+bool ProfileCache::read_data(PortageSettings *settings, CascadingProfile *profile, CascadingProfile **local_profile) {
+	string magic;
+	if(unlikely(!read_string(&magic, NULLPTR)) || unlikely(magic != profile_cache_magic)) {
+		return false;
+	}
+	WordVec key;
+	if(unlikely(!read_words(&key)) || (key != m_key)) {
+		return false;
+	}
+	Stamps::size_type count;
+	if(unlikely(!read_num(&count, NULLPTR))) {
+		return false;
+	}
+	for(; count != 0; --count) {
+		string path, stamp;
+		if(unlikely(!read_string(&path, NULLPTR)) ||
+			unlikely(!read_string(&stamp, NULLPTR))) {
+			return false;
+		}
+		struct stat st;
+		bool recent(false);
+		if(get_stamp(path, &st, &recent) != stamp) {
+			return false;
+		}
+	}
+	WordIterateMap vars;
+	if(unlikely(!read_num(&count, NULLPTR))) {
+		return false;
+	}
+	for(; count != 0; --count) {
+		string var, value;
+		if(unlikely(!read_string(&var, NULLPTR)) ||
+			unlikely(!read_string(&value, NULLPTR))) {
+			return false;
+		}
+		vars[var] = value;
+	}
+	WordVec profile_dirs;
+	if(unlikely(!read_words(&profile_dirs))) {
+		return false;
+	}
+	CascadingProfile global(settings, false);
+	CascadingProfile local(settings, false);
+	eix::UChar have_local;
+	if(unlikely(!read_prelists(&global)) ||
+		unlikely(!readUChar(&have_local, NULLPTR)) ||
+		((have_local != 0) && unlikely(!read_prelists(&local)))) {
+		return false;
+	}
+
+	// Now the data is complete and can be used
+	WordIterateMap& settings_vars(*settings);
+	settings_vars.swap(vars);
+	settings->profile_dirs.swap(profile_dirs);
+	copy_prelists(profile, global);
+	if(have_local != 0) {
+		*local_profile = new CascadingProfile(*profile);
+		copy_prelists(*local_profile, local);
+	} else {
+		*local_profile = NULLPTR;
+	}
+	// The labels are read as a side effect of reading the profile
+	RepoList& repos(settings->repos);
+	for(RepoList::iterator it(repos.begin()); likely(it != repos.end()); ++it) {
+		if((it == repos.begin()) || it->know_path) {
+			it->readLabel();
+		}
+	}
+	return true;
+}
+
+bool ProfileCache::load(PortageSettings *settings, CascadingProfile *profile, CascadingProfile **local_profile) {
+	if(!openread(m_filename.c_str())) {
+		return false;
+	}
+	bool ret(read_data(settings, profile, local_profile));
+	destroy();
+	return ret;
+}
+
+void ProfileCache::save(const PortageSettings& settings, const CascadingProfile& profile, const CascadingProfile *local_profile) {
+	// Write a temporary file first so that readers never see a partial file
+	string temp;
+	if(m_recent || !opentemp(m_filename, &temp)) {
+		return;
+	}
+	bool ok(write_string(profile_cache_magic, NULLPTR) && write_words(m_key) &&
+		write_num(m_stamps.size(), NULLPTR));
+	for(Stamps::const_iterator it(m_stamps.begin()); ok && (it != m_stamps.end()); ++it) {
+		ok = (write_string(it->first, NULLPTR) && write_string(it->second, NULLPTR));
+	}
+	ok = (ok && write_num(settings.size(), NULLPTR));
+	for(PortageSettings::const_iterator it(settings.begin()); ok && (it != settings.end()); ++it) {
+		ok = (write_string(it->first, NULLPTR) && write_string(it->second, NULLPTR));
+	}
+	ok = (ok && write_words(settings.profile_dirs) && write_prelists(profile) &&
+		writeUChar(((local_profile == NULLPTR) ? 0 : 1), NULLPTR) &&
+		((local_profile == NULLPTR) || write_prelists(*local_profile)));
+	if(unlikely(!closewrite() || !ok ||
+		(rename(temp.c_str(), m_filename.c_str()) != 0))) {
+		unlink(temp.c_str());
+	}
+}
@@ -0,0 +1,83 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_PORTAGE_CONF_PROFILECACHE_H_
+#define SRC_PORTAGE_CONF_PROFILECACHE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <map>
+#include <string>
+
+#include "database/io.h"
+#include "eixTk/attribute.h"
+#include "eixTk/stringtypes.h"
+
+class CascadingProfile;
+class PortageSettings;
+class PreList;
+
+/**
+Binary cache of the result of reading the cascading profile:
+The variables from make.defaults, the profile directories and the
+unfinalized mask, keyword and system lists of the global and local profile.
+The cache is used only if the settings before reading the profile are
+unchanged and each file or directory which contributed has the same stamp.
+**/
+class ProfileCache : public Database {
+	private:
+		typedef std::map<std::string, std::string> Stamps;
+
+		std::string m_filename;
+		WordVec m_key;
+		Stamps m_stamps;
+		bool m_recent;
+
+		bool write_prelist(const PreList& l);
+		ATTRIBUTE_NONNULL_ bool read_prelist(PreList *l);
+
+		bool write_prelists(const CascadingProfile& p);
+		ATTRIBUTE_NONNULL_ bool read_prelists(CascadingProfile *p);
+
+		/**
+		Replace the lists of dest by those of src
+		**/
+		ATTRIBUTE_NONNULL_ static void copy_prelists(CascadingProfile *dest, const CascadingProfile& src);
+
+		bool write_words(const WordVec& words);
+		ATTRIBUTE_NONNULL_ bool read_words(WordVec *words);
+
+		ATTRIBUTE_NONNULL_ bool read_data(PortageSettings *settings, CascadingProfile *profile, CascadingProfile **local_profile);
+
+	public:
+		/**
+		@param getlocal whether the local profile is read, too
+		**/
+		ProfileCache(const std::string& filename, const PortageSettings& settings, bool getlocal);
+
+		/**
+		Record path (and, if recursive, the content of directories)
+		as contributing to the profile
+		**/
+		void add_path(const std::string& path, bool recursive);
+
+		/**
+		Set the variables, profile directories and lists from the cache.
+		@param local_profile is set to a new local profile or NULLPTR
+		if the local profile does not differ
+		@return false if the cache cannot be used; nothing is changed then
+		**/
+		ATTRIBUTE_NONNULL_ bool load(PortageSettings *settings, CascadingProfile *profile, CascadingProfile **local_profile);
+
+		/**
+		Store the result, unless a contributing file is too recent
+		to be safely recognized as changed
+		**/
+		void save(const PortageSettings& settings, const CascadingProfile& profile, const CascadingProfile *local_profile);
+};
+
+#endif  // SRC_PORTAGE_CONF_PROFILECACHE_H_
@@ -0,0 +1,245 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Wolfgang Frisch <xororand@users.sourceforge.net>
+//   Emil Beinroth <emilbeinroth@gmx.net>
+//   Martin Väth <martin@mvath.de>
+
+#include "portage/iuse.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
+
+using std::string;
+
+const IUse::Flags
+	IUse::USEFLAGS_NIL,
+	IUse::USEFLAGS_NORMAL,
+	IUse::USEFLAGS_PLUS,
+	IUse::USEFLAGS_MINUS;
+
+/**
+The interned names; a deque keeps references valid when growing
+**/
+typedef std::deque<string> IUseNames;
+typedef UNORDERED_MAP<string, IUse::Id> IUseIds;
+
+static IUseNames *iuse_names = NULLPTR;
+static IUseIds *iuse_ids = NULLPTR;
+
+IUse::Id IUse::intern(const string& name) {
+	if(unlikely(iuse_ids == NULLPTR)) {
+		iuse_names = new IUseNames;
+		iuse_ids = new IUseIds;
+	}
+	IUseIds::const_iterator it(iuse_ids->find(name));
+	if(likely(it != iuse_ids->end())) {
+		return it->second;
+	}
+	Id i(iuse_names->size());
+	iuse_names->PUSH_BACK(name);
+	(*iuse_ids)[name] = i;
+	return i;
+}
+
+const string& IUse::name(Id i) {
+	return (*iuse_names)[i];
+}
+
+IUse::IUse(const string& s) {
+	string n(s);
+	flags = parse(&n);
+	id = intern(n);
+}
+
+IUse::Flags IUse::parse(string *s) {
+	Flags ret(USEFLAGS_NIL);
+	string::size_type c(0);
+	for( ; likely(c < s->length()); ++c) {
+		switch((*s)[c]) {
+			case '+':
+				ret |= USEFLAGS_PLUS;
+				continue;
+			case '-':
+				ret |= USEFLAGS_MINUS;
+				continue;
+			case '[':
+			case '{':
+			case '(':
+				ret |= USEFLAGS_NORMAL;
+				continue;
+			case ']':
+			case '}':
+			case ')':
+			case ' ':
+				continue;
+			default:
+				break;
+		}
+		break;
+	}
+	if(c == 0)
+		return USEFLAGS_NORMAL;
+	s->erase(0, c);
+	if(ret == USEFLAGS_NIL)
+		return USEFLAGS_NORMAL;
+	return ret;
+}
+
+const char *IUse::prefix() const {
+/*
+	For the case that you want to make prefixes/postfixes(?) customizable,
+	you might need to do this independently of this function.
+	This function is used to calculate the strings stored in the cachefile,
+	so each change modifies the cachefile format.
+	The corresponding function for reading the cachefile (or the string
+	passed from the ebuild) is parse() which is intentionally a bit more
+	sloppy about the syntax; so certain minor changes of the prefixes of
+	the cachefile format do not harm.
+*/
+	switch(flags) {
+		case USEFLAGS_PLUS:
+			return "+";
+		case USEFLAGS_MINUS:
+			return "-";
+		case USEFLAGS_NORMAL|USEFLAGS_PLUS:
+			return "(+)";
+		case USEFLAGS_NORMAL|USEFLAGS_MINUS:
+			return "(-)";
+		case USEFLAGS_PLUS|USEFLAGS_MINUS:
+			return "+-";
+		case USEFLAGS_NORMAL|USEFLAGS_PLUS|USEFLAGS_MINUS:
+			return "(+-)";
+		default:
+		// case USEFLAGS_NIL:
+		// case USEFLAGS_NORMAL:
+			return NULLPTR;
+	}
+}
+
+string IUse::asString() const {
+	const char *p(prefix());
+	if(p == NULLPTR) {
+		return name();
+	}
+	string ret(p);
+	ret.append(name());
+	return ret;
+}
+
+static bool iuse_name_less(const IUse& a, const IUse& b) {
+	return (a.name() < b.name());
+}
+
+IUseSet::IUseStd IUseSet::asSorted() const {
+	IUseStd ret(m_iuse);
+	std::sort(ret.begin(), ret.end(), iuse_name_less);
+	return ret;
+}
+
+string IUseSet::asString() const {
+	string ret;
+	IUseStd sorted(asSorted());
+	for(IUseStd::const_iterator it(sorted.begin());
+		likely(it != sorted.end()); ++it) {
+		if(!ret.empty())
+			ret.append(1, ' ');
+		ret.append(it->asString());
+	}
+	return ret;
+}
+
+WordVec IUseSet::asVector() const {
+	IUseStd sorted(asSorted());
+	WordVec ret(sorted.size());
+	WordVec::size_type i(0);
+	for(IUseStd::const_iterator it(sorted.begin());
+		likely(it != sorted.end()); ++i, ++it) {
+		ret[i] = it->asString();
+	}
+	return ret;
+}
+
+void IUseSet::insert(const IUseSet& iuse) {
+	const IUseStd& other(iuse.m_iuse);
+	if(other.empty()) {
+		return;
+	}
+	if(m_iuse.empty()) {
+		m_iuse = other;
+		return;
+	}
+	IUseStd merged;
+	merged.reserve(m_iuse.size() + other.size());
+	IUseStd::const_iterator a(m_iuse.begin()), b(other.begin());
+	while((a != m_iuse.end()) && (b != other.end())) {
+		if(a->id < b->id) {
+			merged.PUSH_BACK(*(a++));
+		} else if(b->id < a->id) {
+			merged.PUSH_BACK(*(b++));
+		} else {
+			merged.EMPLACE_BACK(IUse, (a->id, static_cast<IUse::Flags>(a->flags | b->flags)));
+			++a;
+			++b;
+		}
+	}
+	merged.insert(merged.end(), a, IUseStd::const_iterator(m_iuse.end()));
+	merged.insert(merged.end(), b, other.end());
+	m_iuse.swap(merged);
+}
+
+void IUseSet::insert(const string& iuse) {
+	WordVec vec;
+	split_string(&vec, iuse);
+	for(WordVec::const_iterator it(vec.begin());
+		likely(it != vec.end()); ++it) {
+		push_back(IUse(*it));
+	}
+	finalize();
+}
+
+void IUseSet::insert(const IUse& iuse) {
+	IUseStd::iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), iuse));
+	if((it == m_iuse.end()) || (it->id != iuse.id)) {
+		m_iuse.insert(it, iuse);
+		return;
+	}
+	it->flags |= iuse.flags;
+}
+
+void IUseSet::finalize() {
+	IUseStd::iterator it(m_iuse.begin());
+	if(it == m_iuse.end()) {
+		return;
+	}
+	// Usually, the entries are already sorted
+	for(IUseStd::iterator prev(it++); likely(it != m_iuse.end()); prev = it++) {
+		if(unlikely(!(*prev < *it))) {
+			break;
+		}
+	}
+	if(likely(it == m_iuse.end())) {
+		return;
+	}
+	std::sort(m_iuse.begin(), m_iuse.end());
+	IUseStd::iterator dest(m_iuse.begin());
+	for(IUseStd::iterator src(dest + 1); likely(src != m_iuse.end()); ++src) {
+		if(dest->id == src->id) {
+			dest->flags |= src->flags;
+		} else {
+			*(++dest) = *src;
+		}
+	}
+	m_iuse.erase(dest + 1, m_iuse.end());
+}
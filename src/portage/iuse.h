@@ -0,0 +1,124 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Wolfgang Frisch <xororand@users.sourceforge.net>
+//   Emil Beinroth <emilbeinroth@gmx.net>
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_PORTAGE_IUSE_H_
+#define SRC_PORTAGE_IUSE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringtypes.h"
+
+/**
+An IUSE entry: The name is interned, so that an IUse is only
+an index and flags which can be compared and merged without strings
+**/
+class IUse {
+	public:
+		typedef eix::UChar Flags;
+		static CONSTEXPR const Flags
+			USEFLAGS_NIL    = 0,
+			USEFLAGS_NORMAL = 1,
+			USEFLAGS_PLUS   = 2,
+			USEFLAGS_MINUS  = 4;
+		typedef eix::UNumber Id;
+
+		Id id;
+		Flags flags;
+
+		ATTRIBUTE_NONNULL_ static Flags parse(std::string *s);
+
+		/**
+		@return the unique Id of the name; the name is stored forever
+		**/
+		static Id intern(const std::string& name);
+
+		ATTRIBUTE_PURE static const std::string& name(Id i);
+
+		const std::string& name() const {
+			return name(id);
+		}
+
+		/**
+		Parse a string with prefix
+		**/
+		explicit IUse(const std::string& s);
+
+		IUse(Id i, Flags f) NOEXCEPT : id(i), flags(f) {
+		}
+
+		ATTRIBUTE_PURE const char *prefix() const;
+
+		std::string asString() const;
+
+		bool operator==(const IUse& c) const {
+			return (id == c.id);
+		}
+
+		bool operator<(const IUse& c) const {
+			return (id < c.id);
+		}
+};
+
+class IUseSet {
+	public:
+		/**
+		Sorted by the Id, i.e. not alphabetically
+		**/
+		typedef std::vector<IUse> IUseStd;
+
+		bool empty() const {
+			return m_iuse.empty();
+		}
+
+		void clear() {
+			m_iuse.clear();
+		}
+
+		const IUseStd& asStd() const {
+			return m_iuse;
+		}
+
+		/**
+		@return the entries sorted by their names
+		**/
+		IUseStd asSorted() const;
+
+		void insert(const IUseSet& iuse);
+
+		void insert(const std::string& iuse);
+
+		void insert(const IUse& iuse);
+
+		/**
+		Append an entry; finalize() must be called after the last one
+		**/
+		void push_back(const IUse& iuse) {
+			m_iuse.PUSH_BACK(iuse);
+		}
+
+		/**
+		Sort and merge the entries appended by push_back()
+		**/
+		void finalize();
+
+		std::string asString() const;
+
+		WordVec asVector() const;
+
+	protected:
+		IUseStd m_iuse;
+};
+
+#endif  // SRC_PORTAGE_IUSE_H_
@@ -58,67 +58,79 @@ inline static bool is_testing(const string& s) {
 }
 
 KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const string& keywords) {
-	KeyType m(KEY_EMPTY);
+	return AcceptedKeywords(accepted_keywords).calc_keyflags(keywords);
+}
+
+void AcceptedKeywords::init(const WordSet& accepted) {
+	m_accepted = &accepted;
+	m_some_stable = (find_if(accepted.begin(), accepted.end(), is_not_testing)
+		!= accepted.end());
+	m_some_testing = (find_if(accepted.begin(), accepted.end(), is_testing)
+		!= accepted.end());
+	m_all = (accepted.count("**") != 0);
+	m_star = (accepted.count("*") != 0);
+	m_tilde_star = (accepted.count("~*") != 0);
+	m_cache.clear();
+}
+
+KeywordsFlags::KeyType AcceptedKeywords::calc_keyflags(const string& keywords) const {
+	typedef KeywordsFlags K;
+	const WordSet& accepted_keywords(*m_accepted);
+	K::KeyType m(K::KEY_EMPTY);
 	WordVec keywords_vec;
 	split_string(&keywords_vec, keywords);
 	for(WordVec::const_iterator it(keywords_vec.begin());
 		likely(it != keywords_vec.end()); ++it) {
 		if((*it)[0] == '-') {
 			if(*it == "-*") {
-				m |= KEY_MINUSASTERISK;
+				m |= K::KEY_MINUSASTERISK;
 			} else if(*it == "-~*") {
-				m |= KEY_MINUSUNSTABLE;
+				m |= K::KEY_MINUSUNSTABLE;
 			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_MINUSKEYWORD;
+				m |= K::KEY_MINUSKEYWORD;
 			}
 			continue;
 		}
 		if(*it == "*") {
-			m |= KEY_SOMESTABLE;
-			if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
-				!= accepted_keywords.end()) {
-				m |= KEY_STABLE;
+			m |= K::KEY_SOMESTABLE;
+			if(m_some_stable) {
+				m |= K::KEY_STABLE;
 			}
 			continue;
 		}
 		bool found(false);
 		if(accepted_keywords.count(*it) != 0) {
 			found = true;
-			m |= (KEY_STABLE | KEY_SOMESTABLE);
+			m |= (K::KEY_STABLE | K::KEY_SOMESTABLE);
 		}
 		if((*it)[0] == '~') {
 			if(found) {
-				m |= KEY_ARCHUNSTABLE;
+				m |= K::KEY_ARCHUNSTABLE;
 			} else if(*it == "~*") {
-				m |= KEY_SOMEUNSTABLE;
-				if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
-					!= accepted_keywords.end()) {
-					m |= KEY_STABLE;
+				m |= K::KEY_SOMEUNSTABLE;
+				if(m_some_testing) {
+					m |= K::KEY_STABLE;
 				}
 			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_ARCHUNSTABLE;
+				m |= K::KEY_ARCHUNSTABLE;
 			} else {
-				m |= KEY_ALIENUNSTABLE;
+				m |= K::KEY_ALIENUNSTABLE;
 			}
-		} else if((*it)[0] != '-') {
-			m |= (found ? KEY_ARCHSTABLE : KEY_ALIENSTABLE);
+		} else {
+			m |= (found ? K::KEY_ARCHSTABLE : K::KEY_ALIENSTABLE);
 		}
 	}
-	if(m & KEY_STABLE) {
+	if(m & K::KEY_STABLE) {
 		return m;
 	}
-	if(accepted_keywords.count("**") != 0) {
-		return (m | KEY_STABLE);
+	if(m_all) {
+		return (m | K::KEY_STABLE);
 	}
-	if(m & KEY_SOMESTABLE) {
-		if(accepted_keywords.count("*") != 0) {
-			return (m | KEY_STABLE);
-		}
+	if((m & K::KEY_SOMESTABLE) && m_star) {
+		return (m | K::KEY_STABLE);
 	}
-	if(m & KEY_TILDESTARMATCH) {
-		if(accepted_keywords.count("~*") != 0) {
-			return (m | KEY_STABLE);
-		}
+	if((m & K::KEY_TILDESTARMATCH) && m_tilde_star) {
+		return (m | K::KEY_STABLE);
 	}
 	return m;
 }
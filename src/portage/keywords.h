@@ -17,8 +17,10 @@
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
 
 class MaskFlags {
 	public:
@@ -261,6 +263,47 @@ class KeywordsFlags {
 		KeyType m_keyword;
 };
 
+/**
+The properties of a set of accepted keywords which determine the KeyType
+of a KEYWORDS string. The result for a KEYWORDS string is calculated only
+once: There are much less distinct KEYWORDS strings than versions.
+**/
+class AcceptedKeywords {
+	private:
+		typedef UNORDERED_MAP<std::string, KeywordsFlags::KeyType> Cache;
+		const WordSet *m_accepted;
+		bool m_some_stable, m_some_testing, m_all, m_star, m_tilde_star;
+		mutable Cache m_cache;
+
+	public:
+		AcceptedKeywords() : m_accepted(NULLPTR) {
+		}
+
+		explicit AcceptedKeywords(const WordSet& accepted) {
+			init(accepted);
+		}
+
+		/**
+		accepted must not change or go out of scope until the next init()
+		**/
+		void init(const WordSet& accepted);
+
+		/**
+		Calculate without storing the result
+		**/
+		KeywordsFlags::KeyType calc_keyflags(const std::string& keywords) const;
+
+		KeywordsFlags::KeyType get_keyflags(const std::string& keywords) const {
+			Cache::const_iterator it(m_cache.find(keywords));
+			if(likely(it != m_cache.end())) {
+				return it->second;
+			}
+			KeywordsFlags::KeyType r(calc_keyflags(keywords));
+			m_cache[keywords] = r;
+			return r;
+		}
+};
+
 inline static bool operator==(const KeywordsFlags& left, const KeywordsFlags& right) {
 	return (left.get() == right.get());
 }
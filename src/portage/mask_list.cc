@@ -10,6 +10,10 @@
 #include "portage/mask_list.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <cstring>
 #include <string>
 
 #include "eixTk/attribute.h"
@@ -30,6 +34,118 @@
 class Version;
 using std::string;
 
+/**
+Characters which make a pattern a glob for fnmatch()
+**/
+static const char glob_chars[] = "*?[\\";
+
+MaskWildcards::Glob::Glob(const char *pattern) {
+	if(std::strpbrk(pattern, glob_chars) == NULLPTR) {
+		type = LITERAL;
+		text = pattern;
+		return;
+	}
+	if(std::strcmp(pattern, "*") == 0) {
+		type = ANY;
+		return;
+	}
+	size_t len(std::strlen(pattern));
+	if((pattern[len - 1] == '*') &&
+		(std::strpbrk(string(pattern, len - 1).c_str(), glob_chars) == NULLPTR)) {
+		type = PREFIX;
+		text.assign(pattern, len - 1);
+		return;
+	}
+	if((pattern[0] == '*') && (std::strpbrk(pattern + 1, glob_chars) == NULLPTR)) {
+		type = SUFFIX;
+		text.assign(pattern + 1);
+		return;
+	}
+	type = FNMATCH;
+	text = pattern;
+}
+
+bool MaskWildcards::Glob::match(const string& s) const {
+	switch(type) {
+		case ANY:
+			return true;
+		case LITERAL:
+			return (s == text);
+		case PREFIX:
+			return (s.compare(0, text.size(), text) == 0);
+		case SUFFIX:
+			return ((s.size() >= text.size()) &&
+				(s.compare(s.size() - text.size(), text.size(), text) == 0));
+		default:
+			break;
+	}
+	return (fnmatch(text.c_str(), s.c_str(), FNM_PATHNAME) == 0);
+}
+
+void MaskWildcards::clear() {
+	count = 0;
+	by_category.clear();
+	by_name.clear();
+	rest.clear();
+}
+
+void MaskWildcards::add(const char *category, const char *name) {
+	Entry entry(count++, category, name);
+	if(entry.category.type == Glob::LITERAL) {
+		by_category[entry.category.text].PUSH_BACK(entry);
+	} else if(entry.name.type == Glob::LITERAL) {
+		by_name[entry.name.text].PUSH_BACK(entry);
+	} else {
+		rest.PUSH_BACK(entry);
+	}
+}
+
+void MaskWildcards::find(Matches *m, const Entries& entries, const string& category, const string& name) {
+	for(Entries::const_iterator it(entries.begin());
+		likely(it != entries.end()); ++it) {
+		if(unlikely(it->match(category, name))) {
+			m->PUSH_BACK(it->index);
+		}
+	}
+}
+
+void MaskWildcards::find(Matches *m, const EntriesMap& entries, const string& key, const string& category, const string& name) {
+	EntriesMap::const_iterator it(entries.find(key));
+	if(it != entries.end()) {
+		find(m, it->second, category, name);
+	}
+}
+
+bool MaskWildcards::find(const Entries& entries, const string& category, const string& name) {
+	for(Entries::const_iterator it(entries.begin());
+		likely(it != entries.end()); ++it) {
+		if(unlikely(it->match(category, name))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MaskWildcards::find(const EntriesMap& entries, const string& key, const string& category, const string& name) {
+	EntriesMap::const_iterator it(entries.find(key));
+	return ((it != entries.end()) && find(it->second, category, name));
+}
+
+void MaskWildcards::match(Matches *m, const string& category, const string& name) const {
+	m->clear();
+	find(m, by_category, category, category, name);
+	find(m, by_name, name, category, name);
+	find(m, rest, category, name);
+	// Each bucket is sorted; merge them into the order of insertion
+	std::sort(m->begin(), m->end());
+}
+
+bool MaskWildcards::match(const string& category, const string& name) const {
+	return (find(by_category, category, category, name) ||
+		find(by_name, name, category, name) ||
+		find(rest, category, name));
+}
+
 template<> ATTRIBUTE_NONNULL_ bool MaskList<Mask>::add_file(const char *file, Mask::Type mask_type, bool recursive, bool keep_commentlines, const ParseError *parse_error) {
 	LineVec lines;
 	if(!pushback_lines(file, &lines, recursive, true, (keep_commentlines ? (-1) : 0))) {
@@ -12,8 +12,7 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <fnmatch.h>
-
+#include <cstring>
 #include <map>
 #include <string>
 #include <vector>
@@ -58,20 +57,129 @@ template<typename m_Type> class Masks : protected eix::forward_list<m_Type> {
 		}
 };
 
+/**
+Index of the wildcard entries of a MaskList:
+Entries with a literal category or name are found by a lookup, and
+trivial globs like foo* or *foo are matched without fnmatch().
+**/
+class MaskWildcards {
+	public:
+		typedef WordVec::size_type Index;
+		typedef std::vector<Index> Matches;
+
+		MaskWildcards() : count(0) {
+		}
+
+		void clear();
+
+		/**
+		Add the pattern category/name with the next index
+		**/
+		ATTRIBUTE_NONNULL_ void add(const char *category, const char *name);
+
+		/**
+		Store the indices of all matching patterns in increasing order
+		**/
+		ATTRIBUTE_NONNULL_ void match(Matches *m, const std::string& category, const std::string& name) const;
+
+		/**
+		@return true if some pattern matches
+		**/
+		ATTRIBUTE_PURE bool match(const std::string& category, const std::string& name) const;
+
+	private:
+		class Glob {
+			public:
+				enum Type { ANY, LITERAL, PREFIX, SUFFIX, FNMATCH } type;
+				std::string text;
+
+				ATTRIBUTE_NONNULL_ explicit Glob(const char *pattern);
+
+				ATTRIBUTE_PURE bool match(const std::string& s) const;
+		};
+
+		class Entry {
+			public:
+				Index index;
+				Glob category, name;
+
+				ATTRIBUTE_NONNULL_ Entry(Index i, const char *c, const char *n) : index(i), category(c), name(n) {
+				}
+
+				bool match(const std::string& c, const std::string& n) const {
+					return (category.match(c) && name.match(n));
+				}
+		};
+
+		typedef std::vector<Entry> Entries;
+		typedef std::map<std::string, Entries> EntriesMap;
+
+		Index count;
+		EntriesMap by_category;  ///< literal category
+		EntriesMap by_name;  ///< wildcard category, literal name
+		Entries rest;  ///< wildcard category and name
+
+		ATTRIBUTE_NONNULL_ static void find(Matches *m, const Entries& entries, const std::string& category, const std::string& name);
+
+		ATTRIBUTE_NONNULL_ static void find(Matches *m, const EntriesMap& entries, const std::string& key, const std::string& category, const std::string& name);
+
+		ATTRIBUTE_PURE static bool find(const Entries& entries, const std::string& category, const std::string& name);
+
+		ATTRIBUTE_PURE static bool find(const EntriesMap& entries, const std::string& key, const std::string& category, const std::string& name);
+};
+
 template<typename m_Type> class MaskList {
 	private:
 		typedef typename Masks<m_Type>::const_iterator m_const_iterator;
 		typedef typename std::map<std::string, Masks<m_Type> > FullType;
 		typedef typename FullType::const_iterator full_const_iterator;
-		typedef typename std::map<std::string, Masks<m_Type> > ExactType;
+		typedef typename std::map<std::string, Masks<m_Type> > NameType;
+		typedef typename NameType::const_iterator name_const_iterator;
+		typedef typename std::map<std::string, NameType> ExactType;
 		typedef typename ExactType::const_iterator exact_const_iterator;
 
-		ExactType exact_name;
-		FullType full_name;
+		ExactType exact_name;  ///< category -> name -> masks
+		FullType full_name;  ///< wildcard pattern -> masks
+
+		/**
+		The index of full_name is built when it is first needed
+		**/
+		mutable bool wildcards_valid;
+		mutable MaskWildcards wildcards;
+		mutable std::vector<const Masks<m_Type> *> wildcard_masks;
+
+		void update_wildcards() const {
+			if(likely(wildcards_valid)) {
+				return;
+			}
+			wildcards.clear();
+			wildcard_masks.clear();
+			for(full_const_iterator it(full_name.begin());
+				likely(it != full_name.end()); ++it) {
+				// All masks of an entry have the same category and name
+				const m_Type& m(*(it->second.begin()));
+				wildcards.add(m.getCategory(), m.getName());
+				wildcard_masks.PUSH_BACK(&(it->second));
+			}
+			wildcards_valid = true;
+		}
 
 	public:
 		typedef typename eix::ptr_container<std::vector<const m_Type *> > Get;
 
+		MaskList() : wildcards_valid(false) {
+		}
+
+		MaskList(const MaskList& l) : exact_name(l.exact_name), full_name(l.full_name), wildcards_valid(false) {
+		}
+
+		MaskList& operator=(const MaskList& l) {
+			exact_name = l.exact_name;
+			full_name = l.full_name;
+			wildcards_valid = false;
+			return *this;
+		}
+
 		bool empty() const {
 			return (exact_name.empty() && full_name.empty());
 		}
@@ -79,27 +187,23 @@ template<typename m_Type> class MaskList {
 		void clear() {
 			exact_name.clear();
 			full_name.clear();
+			wildcards_valid = false;
 		}
 
-		inline static bool match_full(const std::string& mask, const std::string& name) {
-			return !fnmatch(mask.c_str(), name.c_str(), FNM_PATHNAME);
-		}
-
-		bool match_full(const std::string& full) const {
-			if(exact_name.count(full) != 0) {
+		bool match(const std::string& category, const std::string& name) const {
+			exact_const_iterator c(exact_name.find(category));
+			if((c != exact_name.end()) && (c->second.count(name) != 0)) {
 				return true;
 			}
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					return true;
-				}
+			if(full_name.empty()) {
+				return false;
 			}
-			return false;
+			update_wildcards();
+			return wildcards.match(category, name);
 		}
 
 		ATTRIBUTE_NONNULL_ bool match_name(const Package *p) const {
-			return match_full(p->category + "/" + p->name);
+			return match(p->category, p->name);
 		}
 
 		ATTRIBUTE_NONNULL_ inline static void push_result(Get **l, const Masks<m_Type>& r) {
@@ -111,38 +215,51 @@ template<typename m_Type> class MaskList {
 			}
 		}
 
-		Get *get_full(const std::string& full) const {
+		/**
+		Results of wildcard entries come first, sorted by the pattern
+		**/
+		Get *get(const std::string& category, const std::string& name) const {
 			Get *l(NULLPTR);
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					push_result(&l, it->second);
+			if(!full_name.empty()) {
+				update_wildcards();
+				MaskWildcards::Matches matches;
+				wildcards.match(&matches, category, name);
+				for(MaskWildcards::Matches::const_iterator it(matches.begin());
+					likely(it != matches.end()); ++it) {
+					push_result(&l, *(wildcard_masks[*it]));
 				}
 			}
-			exact_const_iterator it(exact_name.find(full));
-			if(it != exact_name.end()) {
-				push_result(&l, it->second);
+			exact_const_iterator c(exact_name.find(category));
+			if(c != exact_name.end()) {
+				name_const_iterator n(c->second.find(name));
+				if(n != c->second.end()) {
+					push_result(&l, n->second);
+				}
 			}
 			return l;
 		}
 
 		Get *get_setname(const std::string& setname) const {
-			return get_full(std::string(SET_CATEGORY) + "/" + setname);
+			return get(SET_CATEGORY, setname);
 		}
 
 		ATTRIBUTE_NONNULL_ Get *get(const Package *p) const {
-			return get_full(p->category + "/" + p->name);
+			return get(p->category, p->name);
 		}
 
 		void add(const m_Type& m) {
-			std::string full(m.getCategory());
-			full.append(1, '/');
-			full.append(m.getName());
-			if(full.find_first_of("*?[") == std::string::npos) {
-				exact_name[full].add(m);
+			const char *category(m.getCategory());
+			const char *name(m.getName());
+			if((std::strpbrk(category, "*?[") == NULLPTR) &&
+				(std::strpbrk(name, "*?[") == NULLPTR)) {
+				exact_name[category][name].add(m);
 				return;
 			}
+			std::string full(category);
+			full.append(1, '/');
+			full.append(name);
 			full_name[full].add(m);
+			wildcards_valid = false;
 		}
 
 		/**
@@ -236,6 +353,8 @@ class PreListOrderEntry : public LineVec {
 };
 
 class PreListFilename {
+		friend class ProfileCache;
+
 	private:
 		std::string filename, m_repo;
 		bool know_repo, honour_repo;
@@ -271,6 +390,8 @@ the result looks like this
 This corresponds to portage's sorting.
 **/
 class PreList : public std::vector<PreListEntry> {
+		friend class ProfileCache;
+
 	public:
 		typedef PreListEntry::FilenameIndex FilenameIndex;
 		typedef PreListEntry::LineNumber LineNumber;
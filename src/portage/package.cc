@@ -12,7 +12,9 @@
 
 #include "eixTk/dialect.h"
 #include "eixTk/likely.h"
+#include "eixTk/null.h"
 #include "portage/basicversion.h"
+#include "portage/conf/portagesettings.h"
 #include "portage/extendedversion.h"
 #include "portage/keywords.h"
 #include "portage/version.h"
@@ -38,6 +40,8 @@ void Package::defaults() {
 	know_upgrade_slots = m_has_cached_slotlist =
 		m_has_cached_subslots = false;
 	have_duplicate_versions = DUP_NONE;
+	stability_key = BestCache::KEY_UNKNOWN;
+	m_pending_local = NULLPTR;
 	version_collects = COLLECT_DEFAULT;
 	local_collects.set(MaskFlags::MASK_NONE);
 	saved_collects.fill(MaskFlags(MaskFlags::MASK_NONE));
@@ -86,6 +90,33 @@ void Package::addVersionStart(Version *version) {
 	PUSH_BACK(MOVE(version));
 }
 
+void Package::appendVersionStart(Version *version) {
+	if(unlikely(!empty() && (*version < *back()))) {
+		addVersionStart(version);
+		return;
+	}
+	// Equal versions can only be at the end of the list
+	if(have_duplicate_versions != DUP_OVERLAYS) {
+		bool check_overlays(version->overlay_key != 0);
+		if(check_overlays || (have_duplicate_versions != DUP_SOME)) {
+			for(reverse_iterator ri(rbegin()); likely(ri != rend()); ++ri) {
+				if(likely(BasicVersion::compare(**ri, *version) != 0)) {
+					break;
+				}
+				if(check_overlays && (ri->overlay_key != 0)) {
+					have_duplicate_versions = DUP_OVERLAYS;
+					break;
+				}
+				have_duplicate_versions = DUP_SOME;
+				if(!check_overlays) {
+					break;
+				}
+			}
+		}
+	}
+	PUSH_BACK(MOVE(version));
+}
+
 void Package::collect_iuse(Version *version) {
 	if(version->iuse.empty()) {
 		return;
@@ -131,8 +162,9 @@ void Package::addVersionFinalize(Version *version) {
 	// The reason is that the pointers might go into nirvana, because
 	// a push_back might move the whole list.
 
-	// Mark current slotlist as invalid.
+	// Mark current slotlist and best versions as invalid.
 	m_has_cached_slotlist = m_has_cached_subslots = false;
+	m_best_cache.clear();
 }
 
 /**
@@ -144,3 +176,11 @@ void Package::finalize_masks() {
 		local_collects.setbits(i->maskflags.get());
 	}
 }
+
+void Package::finalize_pending_local() {
+	PortageSettings *ps(m_pending_local);
+	m_pending_local = NULLPTR;
+	ps->calc_local_sets(this);
+	ps->finalize(this);
+	save_maskflags(Version::SAVEMASK_FILE);
+}
@@ -35,6 +35,46 @@
 class VarDbPkg;
 class PortageSettings;
 
+/**
+The best stable and unstable version of a list of versions, valid for the
+stability with which they were determined (see Package::stability_key)
+**/
+class BestCache {
+	public:
+		typedef uint8_t Key;
+		static CONSTEXPR const Key KEY_UNKNOWN = 0xFFU;
+
+		BestCache() {
+			m_key[0] = m_key[1] = KEY_UNKNOWN;
+		}
+
+		/**
+		@return true if *best was set from the cache
+		**/
+		ATTRIBUTE_NONNULL_ bool get(Version **best, bool allow_unstable, Key key) const {
+			unsigned int i(allow_unstable ? 1 : 0);
+			if((key == KEY_UNKNOWN) || (m_key[i] != key)) {
+				return false;
+			}
+			*best = m_best[i];
+			return true;
+		}
+
+		void set(Version *best, bool allow_unstable, Key key) {
+			unsigned int i(allow_unstable ? 1 : 0);
+			m_best[i] = best;
+			m_key[i] = key;
+		}
+
+		void clear() {
+			m_key[0] = m_key[1] = KEY_UNKNOWN;
+		}
+
+	private:
+		Version *m_best[2];
+		Key m_key[2];
+};
+
 /**
 A list of pointer to Versions. Should be kept sorted
 **/
@@ -53,6 +93,8 @@ class SlotVersions {
 	private:
 		const char  *m_slotname;
 		VersionList  m_version_list;
+		mutable BestCache m_best_cache;
+
 	public:
 		const char *slotname() const {
 			return m_slotname;
@@ -69,6 +111,18 @@ class SlotVersions {
 		ATTRIBUTE_NONNULL_ SlotVersions(const char *s, Version *v) :
 			m_slotname(s), m_version_list(v) {
 		}
+
+		/**
+		@return const_version_list().best(allow_unstable), cached for key
+		**/
+		Version *best(bool allow_unstable, BestCache::Key key) const {
+			Version *r;
+			if(!m_best_cache.get(&r, allow_unstable, key)) {
+				r = m_version_list.best(allow_unstable);
+				m_best_cache.set(r, allow_unstable, key);
+			}
+			return r;
+		}
 };
 
 /**
@@ -77,7 +131,11 @@ This list is always sorted with respect to the first version for each slot
 class SlotList : public std::vector<SlotVersions> {
 	public:
 		ATTRIBUTE_NONNULL_ void push_back_largest(Version *version);
-		ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE const VersionList *operator[](const char *s) const;
+		ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE const SlotVersions *find(const char *s) const;
+		ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE const VersionList *operator[](const char *s) const {
+			const SlotVersions *sv(find(s));
+			return ((sv == NULLPTR) ? NULLPTR : &(sv->const_version_list()));
+		}
 };
 
 /**
@@ -102,6 +160,13 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 
 		Duplicates have_duplicate_versions;
 
+		/**
+		The stability which SetStability has set last or
+		BestCache::KEY_UNKNOWN if the stability was changed otherwise.
+		The best versions are cached only for known stabilities.
+		**/
+		BestCache::Key stability_key;
+
 		/**
 		The largest overlay from which one of the version comes.
 		**/
@@ -229,6 +294,12 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		**/
 		ATTRIBUTE_NONNULL_ void addVersionStart(Version *version);
 
+		/**
+		Like addVersionStart(), but faster if version is not smaller than
+		all previously added versions, e.g. when reading from an eix cache
+		**/
+		ATTRIBUTE_NONNULL_ void appendVersionStart(Version *version);
+
 		/**
 		Finishes addVersionStart() after the remaining data have been filled
 		**/
@@ -242,11 +313,30 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 			addVersionFinalize(version);
 		}
 
+		/**
+		Add a version which is not smaller than all previously added ones
+		**/
+		ATTRIBUTE_NONNULL_ void appendVersion(Version *version) {
+			appendVersionStart(version);
+			addVersionFinalize(version);
+		}
+
 		/**
 		Call this after modifying system or world state of versions.
 		**/
 		void finalize_masks();
 
+		/**
+		Apply the local sets and world sets and save the file masks
+		if PackageReader has deferred this. This must happen before
+		sets or masks of the versions are used; SetStability does it.
+		**/
+		void finalize_local() {
+			if(m_pending_local != NULLPTR) {
+				finalize_pending_local();
+			}
+		}
+
 		void save_keyflags(Version::SavedKeyIndex i) {
 			for(iterator it(begin()); likely(it != end()); ++it) {
 				it->save_keyflags(i);
@@ -294,8 +384,8 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 			return true;
 		}
 
-		ATTRIBUTE_PURE Version *best(bool allow_unstable) const;
-		ATTRIBUTE_PURE Version *best() const {
+		Version *best(bool allow_unstable) const;
+		Version *best() const {
 			return best(false);
 		}
 
@@ -491,6 +581,20 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		mutable SlotList m_slotlist;
 		mutable bool m_has_cached_slotlist;
 
+		/**
+		Cache for best()
+		**/
+		mutable BestCache m_best_cache;
+
+		/**
+		The settings for finalize_local() or NULLPTR
+		**/
+		PortageSettings *m_pending_local;
+
+		void finalize_pending_local();
+
+		ATTRIBUTE_PURE Version *calc_best(bool allow_unstable) const;
+
 		/**
 		This is for caching in guess_slotname
 		**/
@@ -517,6 +621,8 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 class PackageSave {
 		typedef UNORDERED_MAP<const Version*, KeywordSave> DataType;
 		DataType data;
+		BestCache::Key stability_key;
+		bool have_package;
 
 	public:
 		explicit PackageSave(const Package *p) {
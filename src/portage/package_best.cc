@@ -55,10 +55,10 @@ void SlotList::push_back_largest(Version *version) {
 	EMPLACE_BACK(SlotVersions, (name, version));
 }
 
-const VersionList *SlotList::operator[](const char *s) const {
+const SlotVersions *SlotList::find(const char *s) const {
 	for(const_iterator it(begin()); likely(it != end()); ++it) {
 		if(unlikely(std::strcmp(s, it->slotname()) == 0)) {
-			return &(it->const_version_list());
+			return &(*it);
 		}
 	}
 	return NULLPTR;
@@ -72,6 +72,15 @@ bool Package::calc_allow_upgrade_slots(const PortageSettings *ps) const {
 }
 
 Version *Package::best(bool allow_unstable) const {
+	Version *r;
+	if(!m_best_cache.get(&r, allow_unstable, stability_key)) {
+		r = calc_best(allow_unstable);
+		m_best_cache.set(r, allow_unstable, stability_key);
+	}
+	return r;
+}
+
+Version *Package::calc_best(bool allow_unstable) const {
 	for(const_reverse_iterator ri(rbegin()); likely(ri != rend()); ++ri) {
 		if(ri->maskflags.isHardMasked()) {
 			continue;
@@ -93,18 +102,18 @@ void Package::build_slotlist() const {
 
 
 Version *Package::best_slot(const char *slot_name, bool allow_unstable) const {
-	const VersionList *vl(slotlist()[slot_name]);
-	if(vl == NULLPTR) {
+	const SlotVersions *sv(slotlist().find(slot_name));
+	if(sv == NULLPTR) {
 		return NULLPTR;
 	}
-	return vl->best(allow_unstable);
+	return sv->best(allow_unstable, stability_key);
 }
 
 void Package::best_slots(Package::VerVec *l, bool allow_unstable) const {
 	l->clear();
 	for(SlotList::const_iterator sit(slotlist().begin());
 		likely(sit != slotlist().end()); ++sit) {
-		Version *p((sit->const_version_list()).best(allow_unstable));
+		Version *p(sit->best(allow_unstable, stability_key));
 		if(p != NULLPTR) {
 			l->PUSH_BACK(p);
 		}
@@ -268,7 +277,7 @@ eix::TinySigned Package::worse_best_slots(const Package& p) const {
 	eix::TinySigned ret(0);
 	for(SlotList::const_iterator it(slotlist().begin());
 		it != slotlist().end(); ++it) {
-		Version *t_best((it->const_version_list()).best());
+		Version *t_best(it->best(false, stability_key));
 		if(!t_best) {
 			continue;
 		}
@@ -472,9 +481,11 @@ eix::TinySigned Package::check_best(VarDbPkg *v, bool only_installed, bool test_
 
 void PackageSave::store(const Package *p) {
 	data.clear();
-	if(p == NULLPTR) {
+	have_package = (p != NULLPTR);
+	if(!have_package) {
 		return;
 	}
+	stability_key = p->stability_key;
 	for(Package::const_iterator it(p->begin());
 		likely(it != p->end()); ++it) {
 		data[*it] = KeywordSave(*it);
@@ -482,6 +493,10 @@ void PackageSave::store(const Package *p) {
 }
 
 void PackageSave::restore(Package *p) const {
+	if(unlikely(!have_package)) {
+		return;
+	}
+	p->stability_key = stability_key;
 	if(unlikely(data.empty())) {
 		return;
 	}
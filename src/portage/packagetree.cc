@@ -10,11 +10,12 @@
 #include "portage/packagetree.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
 #include <string>
 #include <utility>
 
-#include "eixTk/assert.h"
 #include "eixTk/eixint.h"
+#include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
@@ -23,23 +24,35 @@
 using std::pair;
 using std::string;
 
-PackagePtr *comparer = NULLPTR;
+static bool name_less(const PackagePtr& p, const string& name) {
+	return (p->name < name);
+}
 
-void Category::init_static() {
-	eix_assert_static(comparer == NULLPTR);
-	comparer = new PackagePtr(new Package);
+Category::iterator Category::find(const string& pkg_name) {
+	super::iterator it(std::lower_bound(super::begin(), super::end(), pkg_name, name_less));
+	if((it == super::end()) || ((*it)->name != pkg_name)) {
+		return iterator(super::end());
+	}
+	return iterator(it);
 }
 
-Category::iterator Category::find(const std::string& pkg_name) {
-	eix_assert_static(comparer != NULLPTR);
-	(*comparer)->name = pkg_name;
-	return static_cast<const_iterator>(super::find(*comparer));
+Category::const_iterator Category::find(const string& pkg_name) const {
+	super::const_iterator it(std::lower_bound(super::begin(), super::end(), pkg_name, name_less));
+	if((it == super::end()) || ((*it)->name != pkg_name)) {
+		return const_iterator(super::end());
+	}
+	return const_iterator(it);
 }
 
-Category::const_iterator Category::find(const std::string& pkg_name) const {
-	eix_assert_static(comparer != NULLPTR);
-	(*comparer)->name = pkg_name;
-	return static_cast<const_iterator>(super::find(*comparer));
+void Category::addPackage(Package *pkg) {
+	if(likely(empty() || (back()->name < pkg->name))) {
+		PUSH_BACK(PackagePtr(pkg));
+		return;
+	}
+	super::iterator it(std::lower_bound(super::begin(), super::end(), pkg->name, name_less));
+	if(likely((*it)->name != pkg->name)) {
+		insert(it, PackagePtr(pkg));
+	}
 }
 
 #if 0
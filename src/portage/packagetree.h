@@ -13,8 +13,8 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <map>
-#include <set>
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
@@ -23,11 +23,14 @@
 #include "eixTk/stringtypes.h"
 #include "portage/package.h"
 
-class Category : public eix::ptr_container<std::set<PackagePtr> > {
+/**
+The packages of a category, sorted by name in a contiguous vector:
+The caches deliver the packages mostly in sorted order, so that
+insertion is usually an append
+**/
+class Category : public eix::ptr_container<std::vector<PackagePtr> > {
 	public:
-		typedef eix::ptr_container<std::set<PackagePtr> > super;
-
-		static void init_static();
+		typedef eix::ptr_container<std::vector<PackagePtr> > super;
 
 		Category() {
 		}
@@ -36,17 +39,18 @@ class Category : public eix::ptr_container<std::set<PackagePtr> > {
 			delete_and_clear();
 		}
 
-		iterator find(const std::string& pkg_name);
-		const_iterator find(const std::string& pkg_name) const;
+		ATTRIBUTE_PURE iterator find(const std::string& pkg_name);
+		ATTRIBUTE_PURE const_iterator find(const std::string& pkg_name) const;
 
 		Package *findPackage(const std::string& pkg_name) const {
 			const_iterator i(find(pkg_name));
 			return ((i == end()) ? NULLPTR : static_cast<Package *>(*i));
 		}
 
-		ATTRIBUTE_NONNULL_ void addPackage(Package *pkg) {
-			insert(PackagePtr(pkg));
-		}
+		/**
+		As for a set, nothing is inserted if the name exists already
+		**/
+		ATTRIBUTE_NONNULL_ void addPackage(Package *pkg);
 
 		Package *addPackage(const std::string cat_name, const std::string& pkg_name);
 };
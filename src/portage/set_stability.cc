@@ -63,6 +63,7 @@ Version::SavedMaskIndex SetStability::mask_index(bool get_local) const {
 #endif
 
 void SetStability::set_stability(bool get_local, Package *package) const {
+	package->finalize_local();
 	if(get_local) {
 		portagesettings->user_config->setMasks(package, m_filemask_is_profile);
 		portagesettings->user_config->setKeyflags(package);
@@ -70,9 +71,15 @@ void SetStability::set_stability(bool get_local, Package *package) const {
 		portagesettings->setMasks(package, m_filemask_is_profile);
 		portagesettings->setKeyflags(package, m_always_accept_keywords);
 	}
+	// The flags are determined by these values so that the best versions
+	// for them can be cached
+	package->stability_key = BestCache::Key((get_local ? 0x01U : 0x00U) |
+		(m_filemask_is_profile ? 0x02U : 0x00U) |
+		(m_always_accept_keywords ? 0x04U : 0x00U));
 }
 
 void SetStability::calc_version_flags(bool get_local, MaskFlags *maskflags, KeywordsFlags *keyflags, const Version *v, Package *p) const {
+	p->finalize_local();
 #ifndef ALWAYS_RECALCULATE_STABILITY
 	// Can we avoid the calculation by getting the saved flags?
 	Version::SavedMaskIndex mi(mask_index(get_local));
@@ -11,6 +11,12 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
 
 #include <algorithm>
 #include <string>
@@ -28,9 +34,152 @@
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
 #include "portage/instversion.h"
+#include "portage/vardbpkg_snapshot.h"
 
 using std::string;
 
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+/**
+Append the trimmed nonempty lines of data to value, separated by a space
+**/
+static void append_lines(string *value, const char *data, string::size_type len, bool first_line) {
+	const char *end(data + len);
+	while(data != end) {
+		const char *eol(static_cast<const char *>(std::memchr(data, '\n', end - data)));
+		if(eol == NULLPTR) {
+			eol = end;
+		}
+		const char *b(data);
+		const char *e(eol);
+		data = ((eol == end) ? end : (eol + 1));
+		while((b != e) && (std::strchr(spaces, *b) != NULLPTR)) {
+			++b;
+		}
+		while((b != e) && (std::strchr(spaces, *(e - 1)) != NULLPTR)) {
+			--e;
+		}
+		if(b == e) {
+			continue;
+		}
+		if(!value->empty()) {
+			value->append(1, ' ');
+		}
+		value->append(b, e);
+		if(first_line) {
+			return;
+		}
+	}
+}
+
+/**
+Read fd without intermediate lines; usually the stack buffer suffices
+**/
+static bool read_lines_fd(int fd, string *value, bool first_line) {
+	char buf[4096];
+	string::size_type len(0);
+	string big;
+	for(;;) {
+		ssize_t r(read(fd, buf + len, sizeof(buf) - len));
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if(r == 0) {
+			break;
+		}
+		len += r;
+		if(unlikely(len == sizeof(buf))) {
+			big.append(buf, len);
+			len = 0;
+		}
+	}
+	if(likely(big.empty())) {
+		append_lines(value, buf, len, first_line);
+	} else {
+		big.append(buf, len);
+		append_lines(value, big.c_str(), big.size(), first_line);
+	}
+	return true;
+}
+
+VarDbPkg::~VarDbPkg() {
+	if(m_pkgdir_fd >= 0) {
+		close(m_pkgdir_fd);
+	}
+	for(InstVecCat::iterator it(installed.begin());
+		likely(it != installed.end()); ++it) {
+		delete it->second;
+	}
+	// This stores the snapshot if it was modified
+	delete m_snapshot;
+}
+
+void VarDbPkg::use_snapshot(const string& file) {
+	delete m_snapshot;
+	m_snapshot = new VarDbPkgSnapshot(file, m_directory);
+}
+
+int VarDbPkg::open_pkgdir(const string& pkgdir) const {
+	if(likely(pkgdir == m_pkgdir)) {
+		return m_pkgdir_fd;
+	}
+	if(m_pkgdir_fd >= 0) {
+		close(m_pkgdir_fd);
+	}
+	m_pkgdir = pkgdir;
+	m_pkgdir_fd = open((m_directory + pkgdir).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	return m_pkgdir_fd;
+}
+
+bool VarDbPkg::read_file(const Package& p, const BasicVersion *v, const char *file, string *value, bool first_line) const {
+	value->clear();
+	string pkgdir(p.category);
+	pkgdir.append(1, '/');
+	string::size_type pf_start(pkgdir.size());
+	pkgdir.append(p.name);
+	pkgdir.append(1, '-');
+	pkgdir.append(v->getFull());
+	if(m_snapshot != NULLPTR) {
+		LineVec lines;
+		eix::SignedBool r(m_snapshot->get_lines(p.category, pkgdir.substr(pf_start), file, &lines));
+		if(likely(r >= 0)) {
+			if((lines.size() == 1) || (first_line && !lines.empty())) {
+				*value = lines[0];
+			} else {
+				join_to_string(value, lines);
+			}
+			return (r != 0);
+		}
+	}
+	int fd;
+#ifdef HAVE_OPENAT
+	int dirfd(open_pkgdir(pkgdir));
+	if(unlikely(dirfd < 0)) {
+		return false;
+	}
+	fd = openat(dirfd, file, O_RDONLY | O_CLOEXEC);
+#else
+	pkgdir.insert(0, m_directory);
+	pkgdir.append(1, '/');
+	pkgdir.append(file);
+	fd = open(pkgdir.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+	if(fd < 0) {
+		return false;
+	}
+	bool ret(read_lines_fd(fd, value, first_line));
+	close(fd);
+	return ret;
+}
+
 void VarDbPkg::sort_installed(VarDbPkg::InstVecPkg *maping) {
 	for(VarDbPkg::InstVecPkg::iterator it(maping->begin());
 		likely(it != maping->end()); ++it) {
@@ -64,6 +213,16 @@ InstVec *VarDbPkg::getInstalledVector(const string& category, const string& name
 	return &(cat_it->second);
 }
 
+bool VarDbPkg::haveCategory(const string& category) {
+	InstVecCat::iterator map_it(installed.find(category));
+	/* Not yet read */
+	if(map_it == installed.end()) {
+		readCategory(category.c_str());
+		return haveCategory(category);
+	}
+	return ((map_it->second != NULLPTR) && !(map_it->second->empty()));
+}
+
 /**
 @return true if v is in vec. v=NULLPTR is always in vec.
 If a serious result is found and r is nonzero, r points to that result
@@ -165,21 +324,12 @@ bool VarDbPkg::readOverlay(const Package& p, InstVersion *v, const DBHeader& hea
 }
 
 string VarDbPkg::readOverlayLabel(const Package *p, const BasicVersion *v) const {
-	LineVec lines;
-	string dirname(m_directory);
-	dirname.append(p->category);
-	dirname.append(1, '/');
-	dirname.append(p->name);
-	dirname.append(1, '-');
-	dirname.append(v->getFull());
-	pushback_lines((dirname + "/repository").c_str(),
-		&lines, false, false, 1);
-	pushback_lines((dirname + "/REPOSITORY").c_str(),
-		&lines, false, false, 1);
-	if(lines.empty()) {
-		return "";
-	}
-	return lines[0];
+	string label;
+	read_file(*p, v, "repository", &label, true);
+	if(label.empty()) {
+		read_file(*p, v, "REPOSITORY", &label, true);
+	}
+	return label;
 }
 
 bool VarDbPkg::readSlot(const Package& p, InstVersion *v) const {
@@ -192,17 +342,14 @@ bool VarDbPkg::readSlot(const Package& p, InstVersion *v) const {
 	if(v->read_failed) {
 		return false;
 	}
-	LineVec lines;
-	if(unlikely(!pushback_lines(
-		(m_directory + p.category + "/" + p.name + "-" + v->getFull() + "/SLOT").c_str(),
-		&lines, false, false, 1))) {
+	string slot;
+	if(unlikely(!read_file(p, v, "SLOT", &slot, true))) {
 		return (v->read_failed = true);
 	}
-	if((lines.empty()) || (lines[0] == "0")) {
-		v->set_slotname("");
-	} else {
-		v->set_slotname(lines[0]);
+	if(slot == "0") {
+		slot.clear();
 	}
+	v->set_slotname(slot);
 	return (v->know_slot = true);
 }
 
@@ -211,17 +358,11 @@ void VarDbPkg::readEapi(const Package& p, InstVersion *v) const {
 		return;
 	}
 	v->know_eapi = true;
-	LineVec lines;
-	if(unlikely(!pushback_lines(
-		(m_directory + p.category + "/" + p.name + "-" + v->getFull() + "/EAPI").c_str(),
-		&lines, false, false, 1))) {
-		v->eapi.assign("0");
-		return;
-	}
-	if(unlikely((lines.empty()) || (lines[0] == ""))) {
+	string eapi;
+	if(unlikely(!read_file(p, v, "EAPI", &eapi, true)) || unlikely(eapi.empty())) {
 		v->eapi.assign("0");
 	} else {
-		v->eapi.assign(lines[0]);
+		v->eapi.assign(eapi);
 	}
 }
 
@@ -232,23 +373,19 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 	v->know_use = true;
 	v->inst_iuse.clear();
 	v->usedUse.clear();
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
 	WordVec& inst_iuse = v->inst_iuse;
 	WordVec alluse;
 	/**/ {
-		LineVec lines;
-		if(unlikely(!pushback_lines((dirname + "/IUSE").c_str(),
-			&lines, false, false, 1))) {
+		string content;
+		if(unlikely(!read_file(p, v, "IUSE", &content, false))) {
 			return false;
 		}
-		join_and_split(&inst_iuse, lines);
+		split_string(&inst_iuse, content);
 
-		lines.clear();
-		if(unlikely(!pushback_lines((dirname + "/USE").c_str(),
-			&lines, false, false, 1))) {
+		if(unlikely(!read_file(p, v, "USE", &content, false))) {
 			return false;
 		}
-		join_and_split(&alluse, lines);
+		split_string(&alluse, content);
 	}
 	for(WordVec::iterator it(inst_iuse.begin());
 		it != inst_iuse.end(); ++it) {
@@ -295,20 +432,14 @@ void VarDbPkg::readRestricted(const Package& p, InstVersion *v, const DBHeader&
 			return;
 		}
 	}
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
-	LineVec lines;
-	if(unlikely(!pushback_lines((dirname + "/RESTRICT").c_str(),
-		&lines, false, false, 1))) {
+	string restrict;
+	if(unlikely(!read_file(p, v, "RESTRICT", &restrict, false))) {
 		// It is OK that this file does not exist:
 		// Portage does this if RESTRICT is not set.
 		v->restrictFlags = ExtendedVersion::RESTRICT_NONE;
 		return;
 	}
-	if(likely(lines.size() == 1)) {
-		v->set_restrict(lines[0]);
-	} else {
-		v->set_restrict(join_to_string(lines));
-	}
+	v->set_restrict(restrict);
 }
 
 void VarDbPkg::readInstDate(const Package& p, InstVersion *v) const {
@@ -316,21 +447,37 @@ void VarDbPkg::readInstDate(const Package& p, InstVersion *v) const {
 		return;
 	}
 	v->know_instDate = true;
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
-	LineVec datelines;
-	if(use_build_time &&
-		pushback_lines((dirname + "/BUILD_TIME").c_str(),
-			&datelines, false, false, 1)) {
-		for(LineVec::const_iterator it(datelines.begin());
-			it != datelines.end(); ++it) {
-			if(likely((v->instDate = my_atos(it->c_str())) != 0)) {
-				return;
+	if(use_build_time) {
+		string content;
+		if(read_file(p, v, "BUILD_TIME", &content, false)) {
+			WordVec dates;
+			split_string(&dates, content);
+			for(WordVec::const_iterator it(dates.begin());
+				it != dates.end(); ++it) {
+				if(likely((v->instDate = my_atos(it->c_str())) != 0)) {
+					return;
+				}
 			}
 		}
 	}
-	if(unlikely(!get_mtime(&(v->instDate), dirname.c_str()))) {
+	string pf(p.name + "-" + v->getFull());
+	if((m_snapshot != NULLPTR) && m_snapshot->get_mtime(p.category, pf, &(v->instDate))) {
+		return;
+	}
+	string pkgdir(p.category + "/" + pf);
+#ifdef HAVE_OPENAT
+	int dirfd(open_pkgdir(pkgdir));
+	struct stat st;
+	if(likely(dirfd >= 0) && likely(fstat(dirfd, &st) == 0)) {
+		v->instDate = st.st_mtime;
+		return;
+	}
+	v->instDate = 0;
+#else
+	if(unlikely(!get_mtime(&(v->instDate), (m_directory + pkgdir).c_str()))) {
 		v->instDate = 0;
 	}
+#endif
 }
 
 void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& header) const {
@@ -346,28 +493,21 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 		}
 	}
 	v->depend.clear();
-	string dirname(m_directory + p.category + "/" + p.name + "-" + v->getFull());
 	WordVec depend(4);
 	depend[0] = v->depend.get_depend();
 	depend[1] = v->depend.get_rdepend();
 	depend[2] = v->depend.get_pdepend();
 	depend[3] = v->depend.get_bdepend();
 	static CONSTEXPR const char *filenames[4] = {
-		"/DEPEND",
-		"/RDEPEND",
-		"/PDEPEND",
-		"/BDEPEND"
+		"DEPEND",
+		"RDEPEND",
+		"PDEPEND",
+		"BDEPEND"
 	};
 	for(eix::TinyUnsigned i(0); likely(i < 4); ++i) {
-		LineVec lines;
-		if(likely(pushback_lines((dirname + filenames[i]).c_str(),
-			&lines, false, false, 1))) {
-			if(likely(lines.size() == 1)) {
-				depend[i].assign(lines[0]);
-			} else {
-				depend[i].clear();
-				join_to_string(&(depend[i]), lines);
-			}
+		string content;
+		if(likely(read_file(p, v, filenames[i], &content, false))) {
+			depend[i].swap(content);
 		}
 	}
 	v->depend.set(depend[0], depend[1], depend[2], depend[3], true);
@@ -377,28 +517,50 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 Read category from db-directory
 **/
 void VarDbPkg::readCategory(const char *category) {
-	/* Pointer to category DIRectory */
-	DIR *dir_category;
-
-	/* Open category-directory */
-	string dir_category_name(m_directory);
-	dir_category_name.append(category);
-	if((dir_category = opendir(dir_category_name.c_str())) == NULLPTR) {
-		installed[category] = NULLPTR;
-		return;
+	WordVec names;
+	const WordVec *snapshot_names(NULLPTR);
+	if(m_snapshot != NULLPTR) {
+		snapshot_names = m_snapshot->get_names(category);
+	}
+	if(snapshot_names == NULLPTR) {
+		// Must be obtained before reading the directory
+		string stamp;
+		if(m_snapshot != NULLPTR) {
+			stamp = m_snapshot->get_stamp(category);
+		}
+
+		/* Pointer to category DIRectory */
+		DIR *dir_category;
+
+		/* Open category-directory */
+		string dir_category_name(m_directory);
+		dir_category_name.append(category);
+		if((dir_category = opendir(dir_category_name.c_str())) == NULLPTR) {
+			installed[category] = NULLPTR;
+			return;
+		}
+
+		struct dirent *package_entry;  /* current package dirent */
+		/* Cycle through this category */
+		while(likely((package_entry = readdir(dir_category)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
+			if(package_entry->d_name[0] == '.') {
+				continue;  /* Don't want dot-stuff */
+			}
+			names.PUSH_BACK(package_entry->d_name);
+		}
+		closedir(dir_category);
+		if(m_snapshot != NULLPTR) {
+			m_snapshot->add_category(category, stamp, names);
+		}
+		snapshot_names = &names;
 	}
-	dir_category_name.append(1, '/');
+
 	InstVecPkg *category_installed;
 	installed[category] = category_installed = new InstVecPkg;
-
-	struct dirent *package_entry;  /* current package dirent */
-	/* Cycle through this category */
-	while(likely((package_entry = readdir(dir_category)) != NULLPTR)) {  // NOLINT(runtime/threadsafe_fn)
-		if(package_entry->d_name[0] == '.') {
-			continue;  /* Don't want dot-stuff */
-		}
+	for(WordVec::const_iterator it(snapshot_names->begin());
+		likely(it != snapshot_names->end()); ++it) {
 		string curr_name, curr_version;
-		if(unlikely(!ExplodeAtom::split(&curr_name, &curr_version, package_entry->d_name))) {
+		if(unlikely(!ExplodeAtom::split(&curr_name, &curr_version, it->c_str()))) {
 			continue;
 		}
 		string errtext;
@@ -411,7 +573,5 @@ void VarDbPkg::readCategory(const char *category) {
 			(*category_installed)[curr_name].PUSH_BACK(MOVE(instver));
 		}
 	}
-	closedir(dir_category);
-	sort_installed(installed[category]);
+	sort_installed(category_installed);
 }
-
@@ -20,12 +20,14 @@
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
 #include "portage/basicversion.h"
 #include "portage/instversion.h"
 #include "portage/package.h"
 
 class PrintFormat;
 class DBHeader;
+class VarDbPkgSnapshot;
 
 typedef std::vector<InstVersion> InstVec;
 /**
@@ -59,6 +61,31 @@ class VarDbPkg {
 		**/
 		ATTRIBUTE_NONNULL_ void readCategory(const char *category);
 
+		/**
+		Optional copy of the files which are read below
+		**/
+		VarDbPkgSnapshot *m_snapshot;
+
+		/**
+		The directory (relative to m_directory) of the installed version
+		which was opened last and its descriptor (or -1).
+		Subsequent reads of the same version thus open only the files.
+		**/
+		mutable std::string m_pkgdir;
+		mutable int m_pkgdir_fd;
+
+		/**
+		@return descriptor of pkgdir or -1
+		**/
+		int open_pkgdir(const std::string& pkgdir) const;
+
+		/**
+		Read file of the installed version: The trimmed nonempty lines are
+		joined by a space or, if first_line, only the first one is used
+		@return false if the file does not exist
+		**/
+		ATTRIBUTE_NONNULL_ bool read_file(const Package& p, const BasicVersion *v, const char *file, std::string *value, bool first_line) const;
+
 	public:
 		/**
 		Default constructor
@@ -71,15 +98,18 @@ class VarDbPkg {
 			care_of_deps(care_about_deps),
 			get_restrictions(calc_restrictions),
 			care_of_restrictions(care_about_restrictions),
-			use_build_time(build_time) {
+			use_build_time(build_time),
+			m_snapshot(NULLPTR),
+			m_pkgdir_fd(-1) {
 		}
 
-		~VarDbPkg() {
-			for(InstVecCat::iterator it(installed.begin());
-				likely(it != installed.end()); ++it) {
-				delete it->second;
-			}
-		}
+		~VarDbPkg();
+
+		/**
+		Use (and create or update) a snapshot in file instead of reading
+		the installed package database file by file
+		**/
+		void use_snapshot(const std::string& file);
 
 		bool care_slots() const {
 			return care_of_slots;
@@ -128,6 +158,14 @@ class VarDbPkg {
 		bool isInstalled(const Package& p) {
 			return isInVec(getInstalledVector(p));
 		}
+		bool isInstalled(const std::string& category, const std::string& name) {
+			return isInVec(getInstalledVector(category, name));
+		}
+
+		/**
+		@return true if some package of category is installed
+		**/
+		bool haveCategory(const std::string& category);
 
 		/**
 		Test if a particular version is installed from the correct overlay.
@@ -0,0 +1,316 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "portage/vardbpkg_snapshot.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+#include "eixTk/sysutils.h"
+#include "eixTk/utils.h"
+
+using std::string;
+
+static const char snapshot_magic[] = "eix-vardbpkg-snapshot 1\n";
+
+/**
+The files which are read by VarDbPkg
+**/
+static const char *const snapshot_files[] = {
+	"BDEPEND",
+	"BUILD_TIME",
+	"DEPEND",
+	"EAPI",
+	"IUSE",
+	"PDEPEND",
+	"RDEPEND",
+	"REPOSITORY",
+	"RESTRICT",
+	"SLOT",
+	"USE",
+	"repository",
+	NULLPTR
+};
+
+static bool is_snapshot_file(const char *file) {
+	for(const char *const *f(snapshot_files); likely(*f != NULLPTR); ++f) {
+		if(std::strcmp(*f, file) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+Serialization: Numbers are terminated by newline, strings are
+prefixed by their length
+**/
+static void put_num(string *s, eix::UNumber n) {
+	s->append(eix::format("%s\n") % n);
+}
+
+static void put_string(string *s, const string& str) {
+	put_num(s, str.size());
+	s->append(str);
+}
+
+class SnapshotParser {
+	private:
+		const string& m_data;
+		string::size_type m_pos;
+
+	public:
+		explicit SnapshotParser(const string& data, string::size_type pos) : m_data(data), m_pos(pos) {
+		}
+
+		bool at_end() const {
+			return (m_pos >= m_data.size());
+		}
+
+		ATTRIBUTE_NONNULL_ bool num(eix::UNumber *n) {
+			string::size_type end(m_data.find('\n', m_pos));
+			if(unlikely(end == string::npos)) {
+				return false;
+			}
+			*n = my_atou(m_data.substr(m_pos, end - m_pos).c_str());
+			m_pos = end + 1;
+			return true;
+		}
+
+		ATTRIBUTE_NONNULL_ bool str(string *s) {
+			eix::UNumber len;
+			if(unlikely(!num(&len)) || unlikely(m_data.size() - m_pos < len)) {
+				return false;
+			}
+			s->assign(m_data, m_pos, len);
+			m_pos += len;
+			return true;
+		}
+};
+
+VarDbPkgSnapshot::VarDbPkgSnapshot(const string& filename, const string& directory) :
+	m_filename(filename), m_directory(directory), m_modified(false) {
+	load();
+}
+
+VarDbPkgSnapshot::~VarDbPkgSnapshot() {
+	if(m_modified) {
+		save();
+	}
+}
+
+string VarDbPkgSnapshot::get_stamp(const string& category) const {
+	struct stat st;
+	if(stat((m_directory + category).c_str(), &st) != 0) {
+		return "";
+	}
+	// A change in the same second would not be noticed
+	if(unlikely(st.st_mtime + 1 >= std::time(NULLPTR))) {
+		return "";
+	}
+	return eix::format("%s %s %s %s %s")
+		% st.st_dev % st.st_ino % st.st_nlink % st.st_mtime % st.st_ctime;
+}
+
+const WordVec *VarDbPkgSnapshot::get_names(const string& category) {
+	Categories::iterator it(m_categories.find(category));
+	if(it == m_categories.end()) {
+		return NULLPTR;
+	}
+	CategoryEntry& c(it->second);
+	if(!c.valid) {
+		if(c.stamp != get_stamp(category)) {
+			m_categories.erase(it);
+			m_modified = true;
+			return NULLPTR;
+		}
+		c.valid = true;
+	}
+	return &(c.names);
+}
+
+void VarDbPkgSnapshot::add_category(const string& category, const string& stamp, const WordVec& names) {
+	if(stamp.empty()) {
+		return;
+	}
+	CategoryEntry& c(m_categories[category]);
+	c.stamp = stamp;
+	c.valid = true;
+	c.names = names;
+	c.entries.clear();
+	string dir(m_directory + category);
+	dir.append(1, '/');
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		Entry& e(c.entries[*it]);
+		string pfdir(dir + *it);
+		if(unlikely(!::get_mtime(&(e.mtime), pfdir.c_str()))) {
+			e.mtime = 0;
+		}
+		pfdir.append(1, '/');
+		for(const char *const *f(snapshot_files); likely(*f != NULLPTR); ++f) {
+			LineVec lines;
+			if(pushback_lines((pfdir + *f).c_str(), &lines, false, false, 1)) {
+				e.files[*f] = lines;
+			}
+		}
+	}
+	m_modified = true;
+}
+
+const VarDbPkgSnapshot::Entry *VarDbPkgSnapshot::find(const string& category, const string& pf) const {
+	Categories::const_iterator c(m_categories.find(category));
+	if((c == m_categories.end()) || !(c->second.valid)) {
+		return NULLPTR;
+	}
+	Entries::const_iterator e(c->second.entries.find(pf));
+	if(e == c->second.entries.end()) {
+		return NULLPTR;
+	}
+	return &(e->second);
+}
+
+eix::SignedBool VarDbPkgSnapshot::get_lines(const string& category, const string& pf, const char *file, LineVec *lines) const {
+	const Entry *e(find(category, pf));
+	if((e == NULLPTR) || !is_snapshot_file(file)) {
+		return -1;
+	}
+	Files::const_iterator f(e->files.find(file));
+	if(f == e->files.end()) {
+		return 0;
+	}
+	lines->insert(lines->end(), f->second.begin(), f->second.end());
+	return 1;
+}
+
+bool VarDbPkgSnapshot::get_mtime(const string& category, const string& pf, std::time_t *mtime) const {
+	const Entry *e(find(category, pf));
+	if(e == NULLPTR) {
+		return false;
+	}
+	*mtime = e->mtime;
+	return true;
+}
+
+void VarDbPkgSnapshot::load() {
+	FILE *fp(std::fopen(m_filename.c_str(), "rb"));
+	if(fp == NULLPTR) {
+		return;
+	}
+	string data;
+	char buf[8192];
+	size_t r;
+	while((r = std::fread(buf, 1, sizeof(buf), fp)) != 0) {
+		data.append(buf, r);
+	}
+	std::fclose(fp);
+	const string::size_type magic_len(sizeof(snapshot_magic) - 1);
+	if(data.compare(0, magic_len, snapshot_magic) != 0) {
+		return;
+	}
+	SnapshotParser p(data, magic_len);
+	while(!p.at_end()) {
+		string category;
+		CategoryEntry c;
+		eix::UNumber count;
+		if(unlikely(!p.str(&category)) || unlikely(!p.str(&c.stamp)) ||
+			unlikely(!p.num(&count))) {
+			m_categories.clear();
+			return;
+		}
+		for(; count != 0; --count) {
+			string pf, mtime;
+			eix::UNumber files;
+			if(unlikely(!p.str(&pf)) || unlikely(!p.str(&mtime)) ||
+				unlikely(!p.num(&files))) {
+				m_categories.clear();
+				return;
+			}
+			c.names.PUSH_BACK(pf);
+			Entry& e(c.entries[pf]);
+			e.mtime = my_atos(mtime.c_str());
+			for(; files != 0; --files) {
+				string file;
+				eix::UNumber lines;
+				if(unlikely(!p.str(&file)) || unlikely(!p.num(&lines))) {
+					m_categories.clear();
+					return;
+				}
+				LineVec& l(e.files[file]);
+				l.resize(lines);
+				for(LineVec::iterator it(l.begin()); likely(it != l.end()); ++it) {
+					if(unlikely(!p.str(&(*it)))) {
+						m_categories.clear();
+						return;
+					}
+				}
+			}
+		}
+		m_categories[category] = c;
+	}
+}
+
+void VarDbPkgSnapshot::save() const {
+	string data(snapshot_magic);
+	for(Categories::const_iterator c(m_categories.begin());
+		likely(c != m_categories.end()); ++c) {
+		put_string(&data, c->first);
+		put_string(&data, c->second.stamp);
+		const WordVec& names(c->second.names);
+		put_num(&data, names.size());
+		for(WordVec::const_iterator n(names.begin()); likely(n != names.end()); ++n) {
+			const Entry& e(c->second.entries.find(*n)->second);
+			put_string(&data, *n);
+			put_string(&data, eix::format("%s") % e.mtime);
+			put_num(&data, e.files.size());
+			for(Files::const_iterator f(e.files.begin());
+				likely(f != e.files.end()); ++f) {
+				put_string(&data, f->first);
+				put_num(&data, f->second.size());
+				for(LineVec::const_iterator l(f->second.begin());
+					likely(l != f->second.end()); ++l) {
+					put_string(&data, *l);
+				}
+			}
+		}
+	}
+	// Write a temporary file first so that readers never see a partial file
+	string temp(m_filename + ".XXXXXX");
+	int fd(mkstemp(&(temp[0])));
+	if(fd == -1) {
+		return;
+	}
+	// The data is as public as the installed package database
+	fchmod(fd, 0644);
+	const char *buf(data.c_str());
+	size_t len(data.size());
+	while(len != 0) {
+		ssize_t w(write(fd, buf, len));
+		if(unlikely(w <= 0)) {
+			break;
+		}
+		buf += w;
+		len -= w;
+	}
+	if(unlikely((close(fd) != 0) || (len != 0) ||
+		(rename(temp.c_str(), m_filename.c_str()) != 0))) {
+		unlink(temp.c_str());
+	}
+}
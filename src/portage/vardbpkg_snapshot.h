@@ -0,0 +1,104 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_PORTAGE_VARDBPKG_SNAPSHOT_H_
+#define SRC_PORTAGE_VARDBPKG_SNAPSHOT_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <ctime>
+#include <map>
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
+#include "eixTk/stringtypes.h"
+
+/**
+A copy of the files of the installed package database which eix reads.
+A category is only used if its directory has not changed since it was
+stored; otherwise it is read again from disk and replaces the old data.
+**/
+class VarDbPkgSnapshot {
+	public:
+		/**
+		@param filename the file to load and to save
+		@param directory the installed package database, ending with /
+		**/
+		VarDbPkgSnapshot(const std::string& filename, const std::string& directory);
+
+		/**
+		Save if something has changed
+		**/
+		~VarDbPkgSnapshot();
+
+		/**
+		@return the package directories of category or NULLPTR if the
+		category is not in the snapshot or has changed
+		**/
+		const WordVec *get_names(const std::string& category);
+
+		/**
+		Store the package directories of category together with their files
+		@param stamp the result of get_stamp() before reading the directory
+		**/
+		void add_category(const std::string& category, const std::string& stamp, const WordVec& names);
+
+		/**
+		@return stamp of category or empty string if the directory is too
+		recent to be safely stored or cannot be read
+		**/
+		std::string get_stamp(const std::string& category) const;
+
+		/**
+		Get the lines of the file in category/pf as pushback_lines(file,
+		lines, false, false, 1) does
+		@return 1 (file exists), 0 (does not exist), or -1 (unknown)
+		**/
+		ATTRIBUTE_NONNULL_ eix::SignedBool get_lines(const std::string& category, const std::string& pf, const char *file, LineVec *lines) const;
+
+		/**
+		@return true if mtime of category/pf is stored
+		**/
+		ATTRIBUTE_NONNULL_ bool get_mtime(const std::string& category, const std::string& pf, std::time_t *mtime) const;
+
+	private:
+		typedef std::map<std::string, LineVec> Files;
+
+		class Entry {
+			public:
+				std::time_t mtime;
+				Files files;
+		};
+
+		typedef std::map<std::string, Entry> Entries;
+
+		class CategoryEntry {
+			public:
+				std::string stamp;
+				bool valid;  ///< stamp was checked
+				WordVec names;
+				Entries entries;
+
+				CategoryEntry() : valid(false) {
+				}
+		};
+
+		typedef std::map<std::string, CategoryEntry> Categories;
+
+		std::string m_filename, m_directory;
+		Categories m_categories;
+		bool m_modified;
+
+		ATTRIBUTE_PURE const Entry *find(const std::string& category, const std::string& pf) const;
+
+		void load();
+
+		void save() const;
+};
+
+#endif  // SRC_PORTAGE_VARDBPKG_SNAPSHOT_H_
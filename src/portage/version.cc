@@ -21,139 +21,6 @@
 
 using std::string;
 
-const IUse::Flags
-	IUse::USEFLAGS_NIL,
-	IUse::USEFLAGS_NORMAL,
-	IUse::USEFLAGS_PLUS,
-	IUse::USEFLAGS_MINUS;
-
-IUse::Flags IUse::parse(string *s) {
-	Flags ret(USEFLAGS_NIL);
-	string::size_type c(0);
-	for( ; likely(c < s->length()); ++c) {
-		switch((*s)[c]) {
-			case '+':
-				ret |= USEFLAGS_PLUS;
-				continue;
-			case '-':
-				ret |= USEFLAGS_MINUS;
-				continue;
-			case '[':
-			case '{':
-			case '(':
-				ret |= USEFLAGS_NORMAL;
-				continue;
-			case ']':
-			case '}':
-			case ')':
-			case ' ':
-				continue;
-			default:
-				break;
-		}
-		break;
-	}
-	if(c == 0)
-		return USEFLAGS_NORMAL;
-	s->erase(0, c);
-	if(ret == USEFLAGS_NIL)
-		return USEFLAGS_NORMAL;
-	return ret;
-}
-
-const char *IUse::prefix() const {
-/*
-	For the case that you want to make prefixes/postfixes(?) customizable,
-	you might need to do this independently of this function.
-	This function is used to calculate the strings stored in the cachefile,
-	so each change modifies the cachefile format.
-	The corresponding function for reading the cachefile (or the string
-	passed from the ebuild) is parse() which is intentionally a bit more
-	sloppy about the syntax; so certain minor changes of the prefixes of
-	the cachefile format do not harm.
-*/
-	switch(flags) {
-		case USEFLAGS_PLUS:
-			return "+";
-		case USEFLAGS_MINUS:
-			return "-";
-		case USEFLAGS_NORMAL|USEFLAGS_PLUS:
-			return "(+)";
-		case USEFLAGS_NORMAL|USEFLAGS_MINUS:
-			return "(-)";
-		case USEFLAGS_PLUS|USEFLAGS_MINUS:
-			return "+-";
-		case USEFLAGS_NORMAL|USEFLAGS_PLUS|USEFLAGS_MINUS:
-			return "(+-)";
-		default:
-		// case USEFLAGS_NIL:
-		// case USEFLAGS_NORMAL:
-			return NULLPTR;
-	}
-}
-
-string IUse::asString() const {
-	const char *p(prefix());
-	if(p == NULLPTR) {
-		return name();
-	}
-	string ret(p);
-	ret.append(name());
-	return ret;
-}
-
-string IUseSet::asString() const {
-	string ret;
-	for(IUseStd::const_iterator it(m_iuse.begin());
-		likely(it != m_iuse.end()); ++it) {
-		if(!ret.empty())
-			ret.append(1, ' ');
-		ret.append(it->asString());
-	}
-	return ret;
-}
-
-WordVec IUseSet::asVector() const {
-	WordVec ret(m_iuse.size());
-	WordVec::size_type i(0);
-	for(IUseStd::const_iterator it(m_iuse.begin());
-		likely(it != m_iuse.end()); ++i, ++it) {
-		ret[i] = it->asString();
-	}
-	return ret;
-}
-
-void IUseSet::insert(const IUseStd& iuse) {
-	for(IUseStd::const_iterator it(iuse.begin());
-		likely(it != iuse.end()); ++it) {
-		insert(*it);
-	}
-}
-
-void IUseSet::insert(const string& iuse) {
-	WordVec vec;
-	split_string(&vec, iuse);
-	for(WordVec::const_iterator it(vec.begin());
-		likely(it != vec.end()); ++it) {
-		insert_fast(*it);
-	}
-}
-
-void IUseSet::insert(const IUse& iuse) {
-	IUseStd::iterator it(m_iuse.find(iuse));
-	if(it == m_iuse.end()) {
-		m_iuse.insert(iuse);
-		return;
-	}
-	IUse::Flags oriflags(it->flags);
-	IUse::Flags newflags(oriflags | (iuse.flags));
-	if(newflags == oriflags) {
-		return;
-	}
-	m_iuse.erase(it);
-	m_iuse.EMPLACE(IUse, (iuse.name(), newflags));
-}
-
 const Version::EffectiveState
 	Version::EFFECTIVE_UNSAVED,
 	Version::EFFECTIVE_USED,
@@ -25,6 +25,7 @@
 #include "eixTk/stringtypes.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
+#include "portage/iuse.h"
 #include "portage/keywords.h"
 #include "portage/packagesets.h"
 
@@ -32,80 +33,6 @@ class Database;
 class DBHeader;
 class OutputString;
 
-class IUse : public std::string {
-	public:
-		typedef eix::UChar Flags;
-		static CONSTEXPR const Flags
-			USEFLAGS_NIL    = 0,
-			USEFLAGS_NORMAL = 1,
-			USEFLAGS_PLUS   = 2,
-			USEFLAGS_MINUS  = 4;
-		Flags flags;
-
-		ATTRIBUTE_NONNULL_ static Flags parse(std::string *s);
-
-		std::string& name() {
-			return *static_cast<std::string *>(this);
-		}
-
-		const std::string& name() const {
-			return *static_cast<const std::string *>(this);
-		}
-
-		explicit IUse(const std::string& s) : std::string(s) {
-			flags = parse(&name());
-		}
-
-		IUse(const std::string& s, Flags f) : std::string(s), flags(f) {
-		}
-
-		ATTRIBUTE_PURE const char *prefix() const;
-
-		std::string asString() const;
-
-		bool operator==(const IUse& c) const {
-			return (name() == c.name());
-		}
-};
-
-class IUseSet {
-	public:
-		typedef std::set<IUse> IUseStd;
-
-		bool empty() const {
-			return m_iuse.empty();
-		}
-
-		void clear() {
-			m_iuse.clear();
-		}
-
-		const IUseStd& asStd() const {
-			return m_iuse;
-		}
-
-		void insert(const IUseStd& iuse);
-
-		void insert(const IUseSet& iuse) {
-			insert(iuse.asStd());
-		}
-
-		void insert(const std::string& iuse);
-
-		void insert_fast(const std::string& iuse) {
-			insert(IUse(iuse));
-		}
-
-		std::string asString() const;
-
-		WordVec asVector() const;
-
-	protected:
-		IUseStd m_iuse;
-
-		void insert(const IUse& iuse);
-};
-
 /**
 Version expands the BasicVersion class by data relevant for versions in tree/overlays.
 **/
@@ -266,6 +193,15 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 			keyflags.set_keyflags(get_keyflags(accepted_keywords));
 		}
 
+		KeywordsFlags::KeyType get_keyflags(const AcceptedKeywords& accepted_keywords) const {
+			return accepted_keywords.get_keyflags((effective_state == EFFECTIVE_USED) ?
+				effective_keywords : full_keywords);
+		}
+
+		void set_keyflags(const AcceptedKeywords& accepted_keywords) {
+			keyflags.set_keyflags(get_keyflags(accepted_keywords));
+		}
+
 		void add_reason(const StringList& reason);
 
 		ATTRIBUTE_NONNULL_ void reasons_string(OutputString *s, const OutputString& skip, const OutputString& sep) const;
@@ -14,9 +14,11 @@
 
 #include <cstring>
 
+#include <queue>
 #include <string>
 
 #include "eixTk/assert.h"
+#include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "portage/package.h"
@@ -35,31 +37,51 @@ fnmatch(3) tells that this is a GNU extension.
 using std::string;
 
 FuzzyAlgorithm::LevenshteinMap *FuzzyAlgorithm::levenshtein_map = NULLPTR;
+bool FuzzyAlgorithm::in_use = false;
 
-bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
-	if(can_simplify() && unlikely(!have_simplified) && likely(simplify)) {
-		have_simplified = true;
-		// cut out the first nonempty valid search string
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(likely(is_valid_pkgpath(search_string[i]))) {
-				if(unlikely(i > 0)) {
-					search_string.erase(0, i);
-				}
-				break;
+const MultiAlgorithm::Accept
+	MultiAlgorithm::ACCEPT_NONE,
+	MultiAlgorithm::ACCEPT_BEGIN,
+	MultiAlgorithm::ACCEPT_SUBSTRING;
+
+void BaseAlgorithm::simplify_string() {
+	if(!can_simplify() || likely(have_simplified)) {
+		return;
+	}
+	have_simplified = true;
+	// cut out the first nonempty valid search string
+	for(string::size_type i = 0; i < search_string.length(); ++i) {
+		if(likely(is_valid_pkgpath(search_string[i]))) {
+			if(unlikely(i > 0)) {
+				search_string.erase(0, i);
 			}
+			break;
 		}
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(unlikely(!is_valid_pkgpath(search_string[i]))) {
-				if(likely(i > 0)) {
-					search_string.erase(i);
-				}
-				break;
+	}
+	for(string::size_type i = 0; i < search_string.length(); ++i) {
+		if(unlikely(!is_valid_pkgpath(search_string[i]))) {
+			if(likely(i > 0)) {
+				search_string.erase(i);
 			}
+			break;
 		}
 	}
+}
+
+bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
+	if(likely(simplify)) {
+		simplify_string();
+	}
 	return (*this)(s, p);
 }
 
+const string& BaseAlgorithm::get_string(bool simplify) {
+	if(simplify) {
+		simplify_string();
+	}
+	return search_string;
+}
+
 void FuzzyAlgorithm::init_static() {
 	eix_assert_static(levenshtein_map == NULLPTR);
 	levenshtein_map = new LevenshteinMap;
@@ -103,3 +125,137 @@ bool EndAlgorithm::operator()(const char *s, Package * /* p */) const {
 bool PatternAlgorithm::operator()(const char *s, Package * /* p */) const {
 	return (fnmatch(search_string.c_str(), s, FNMATCH_FLAGS) == 0);
 }
+
+void MultiAlgorithm::add(Combine how, const string& s) {
+	switch(how) {
+		case COMBINE_EXACT:
+			exact.INSERT(s);
+			break;
+		case COMBINE_BEGIN:
+			begin_list.PUSH_BACK(s);
+			break;
+		default:
+		// case COMBINE_SUBSTRING:
+			substring_list.PUSH_BACK(s);
+			break;
+	}
+}
+
+void MultiAlgorithm::insert(const string& s, Accept a) {
+	State curr(0);
+	for(string::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
+		State& next(delta[curr * classes + byte_class[static_cast<unsigned char>(*it)]]);
+		if(next == 0) {
+			next = static_cast<State>(accept.size());
+			delta.resize(delta.size() + classes, 0);
+			accept.PUSH_BACK(ACCEPT_NONE);
+			depth.PUSH_BACK(depth[curr] + 1);
+			// next is invalidated by resize
+			curr = static_cast<State>(accept.size() - 1);
+			continue;
+		}
+		curr = next;
+	}
+	accept[curr] |= a;
+}
+
+void MultiAlgorithm::finalize() {
+	std::memset(byte_class, 0, sizeof(byte_class));
+	classes = 1;
+	for(PatternList::const_iterator it(begin_list.begin());
+		likely(it != begin_list.end()); ++it) {
+		for(string::const_iterator c(it->begin()); likely(c != it->end()); ++c) {
+			ByteClass& b(byte_class[static_cast<unsigned char>(*c)]);
+			if(b == 0) {
+				b = classes++;
+			}
+		}
+	}
+	for(PatternList::const_iterator it(substring_list.begin());
+		likely(it != substring_list.end()); ++it) {
+		for(string::const_iterator c(it->begin()); likely(c != it->end()); ++c) {
+			ByteClass& b(byte_class[static_cast<unsigned char>(*c)]);
+			if(b == 0) {
+				b = classes++;
+			}
+		}
+	}
+
+	// Build the trie; state 0 is the root, so 0 means "no edge" here
+	delta.assign(classes, 0);
+	accept.assign(1, ACCEPT_NONE);
+	depth.assign(1, 0);
+	for(PatternList::const_iterator it(begin_list.begin());
+		likely(it != begin_list.end()); ++it) {
+		insert(*it, ACCEPT_BEGIN);
+	}
+	for(PatternList::const_iterator it(substring_list.begin());
+		likely(it != substring_list.end()); ++it) {
+		insert(*it, ACCEPT_SUBSTRING);
+	}
+	always = (accept[0] != ACCEPT_NONE);
+	only_begin = substring_list.empty();
+	begin_list.clear();
+	substring_list.clear();
+
+	// Turn the trie into the automaton by following the failure links
+	// in breadth-first order; only substring acceptance is inherited
+	// since a begin pattern must be reached without any failure.
+	std::vector<State> fail(accept.size(), 0);
+	std::queue<State> todo;
+	for(ByteClass c(1); likely(c < classes); ++c) {
+		State next(delta[c]);
+		if(next != 0) {
+			todo.push(next);
+		}
+	}
+	while(!todo.empty()) {
+		State curr(todo.front());
+		todo.pop();
+		State *row(&(delta[curr * classes]));
+		const State *fail_row(&(delta[fail[curr] * classes]));
+		for(ByteClass c(1); likely(c < classes); ++c) {
+			State next(row[c]);
+			if(next == 0) {
+				row[c] = fail_row[c];
+				continue;
+			}
+			fail[next] = fail_row[c];
+			accept[next] |= (accept[fail[next]] & ACCEPT_SUBSTRING);
+			todo.push(next);
+		}
+	}
+}
+
+bool MultiAlgorithm::operator()(const char *s, Package * /* p */) const {
+	if(unlikely(always)) {
+		return true;
+	}
+	if(!exact.empty() && (exact.count(s) != 0)) {
+		return true;
+	}
+	if(classes == 1) {
+		return false;
+	}
+	State curr(0);
+	string::size_type pos(0);
+	for(; likely(*s != '\0'); ++s) {
+		curr = delta[curr * classes + byte_class[static_cast<unsigned char>(*s)]];
+		++pos;
+		Accept a(accept[curr]);
+		if(likely(a == ACCEPT_NONE)) {
+			if(only_begin && (depth[curr] != pos)) {
+				// We left the trie: No begin pattern can match anymore
+				return false;
+			}
+			continue;
+		}
+		if((a & ACCEPT_SUBSTRING) != ACCEPT_NONE) {
+			return true;
+		}
+		if(depth[curr] == pos) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -13,11 +13,14 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/inttypes.h"
 #include "eixTk/regexp.h"
 #include "eixTk/unordered_map.h"
+#include "eixTk/unordered_set.h"
 #include "search/levenshtein.h"
 
 class Package;
@@ -29,6 +32,17 @@ That's how every algorithm will look like.
 class BaseAlgorithm {
 		friend class matchtree;
 
+	public:
+		/**
+		How the algorithm can be merged into a MultiAlgorithm
+		**/
+		enum Combine {
+			COMBINE_NONE,
+			COMBINE_EXACT,
+			COMBINE_BEGIN,
+			COMBINE_SUBSTRING
+		};
+
 	protected:
 		std::string search_string;
 		bool have_simplified;
@@ -37,6 +51,8 @@ class BaseAlgorithm {
 			return true;
 		}
 
+		void simplify_string();
+
 	public:
 		virtual void setString(const std::string& s) {
 			search_string = s;
@@ -49,6 +65,22 @@ class BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) virtual bool operator()(const char *s, Package *p) const = 0;
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p, bool simplify);
+
+		virtual Combine combine() const {
+			return COMBINE_NONE;
+		}
+
+		/**
+		@return true if matching has effects beyond the result
+		**/
+		virtual bool has_side_effects() const {
+			return false;
+		}
+
+		/**
+		@return the search string as the first call with simplify would use it
+		**/
+		const std::string& get_string(bool simplify);
 };
 
 /**
@@ -79,6 +111,10 @@ exact string matching
 class ExactAlgorithm FINAL : public BaseAlgorithm {
 	public:
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		Combine combine() const OVERRIDE {
+			return COMBINE_EXACT;
+		}
 };
 
 /**
@@ -89,6 +125,10 @@ class SubstringAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return (std::string(s).find(search_string) != std::string::npos);
 		}
+
+		Combine combine() const OVERRIDE {
+			return COMBINE_SUBSTRING;
+		}
 };
 
 /**
@@ -97,6 +137,10 @@ begin-of-string matching
 class BeginAlgorithm FINAL : public BaseAlgorithm {
 	public:
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		Combine combine() const OVERRIDE {
+			return COMBINE_BEGIN;
+		}
 };
 
 /**
@@ -123,22 +167,40 @@ class FuzzyAlgorithm FINAL : public BaseAlgorithm {
 		typedef UNORDERED_MAP<std::string, Levenshtein> LevenshteinMap;
 		static LevenshteinMap *levenshtein_map;
 
+		/**
+		Set once any FuzzyAlgorithm is constructed for the match tree
+		**/
+		static bool in_use;
+
 		bool can_simplify() const OVERRIDE {
 			return false;
 		}
 
 	public:
 		explicit FuzzyAlgorithm(Levenshtein max) : max_levenshteindistance(max) {
+			in_use = true;
 		}
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p) const OVERRIDE;
 
 		ATTRIBUTE_NONNULL_ static bool compare(Package *p1, Package *p2);
 
+		bool has_side_effects() const OVERRIDE {
+			return true;
+		}
+
 		static bool sort_by_levenshtein() {
 			return (!levenshtein_map->empty());
 		}
 
+		/**
+		@return true if some test uses fuzzy matching, so the results
+		might need sorting by Levenshtein distance after matching
+		**/
+		static bool used() {
+			return in_use;
+		}
+
 		static void init_static();
 };
 
@@ -155,4 +217,71 @@ class PatternAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
 };
 
+/**
+Several exact, begin-of-string, or substring patterns in a single pass.
+Exact patterns are looked up in a hash set; the others are compiled
+into an Aho-Corasick automaton over the bytes occurring in the patterns.
+**/
+class MultiAlgorithm FINAL : public BaseAlgorithm {
+	protected:
+		typedef uint32_t State;
+		typedef uint16_t ByteClass;
+		typedef uint8_t Accept;
+		static CONSTEXPR const Accept
+			ACCEPT_NONE      = 0x00U,
+			ACCEPT_BEGIN     = 0x01U,  ///< A begin pattern ends here
+			ACCEPT_SUBSTRING = 0x02U;  ///< A substring pattern is a suffix
+
+		typedef UNORDERED_SET<std::string> ExactSet;
+		ExactSet exact;
+
+		/**
+		Patterns are only collected until finalize() is called
+		**/
+		typedef std::vector<std::string> PatternList;
+		PatternList begin_list, substring_list;
+
+		/**
+		Byte classes: 0 for bytes in no pattern, otherwise 1..classes-1
+		**/
+		ByteClass byte_class[256];
+		ByteClass classes;
+
+		/**
+		Transition table of the automaton, classes entries per state
+		**/
+		std::vector<State> delta;
+		std::vector<Accept> accept;
+		std::vector<std::string::size_type> depth;
+
+		/**
+		Matches without looking at the string (an empty begin/substring)
+		**/
+		bool always;
+
+		/**
+		There are no substring patterns, so we can stop early
+		**/
+		bool only_begin;
+
+		bool can_simplify() const OVERRIDE {
+			return false;
+		}
+
+		void insert(const std::string& s, Accept a);
+
+	public:
+		MultiAlgorithm() : classes(1), always(false), only_begin(true) {
+		}
+
+		void add(Combine how, const std::string& s);
+
+		/**
+		Build the automaton. Must be called after the last add()
+		**/
+		void finalize();
+
+		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+};
+
 #endif  // SRC_SEARCH_ALGORITHMS_H_
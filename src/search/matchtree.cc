@@ -14,14 +14,21 @@
 #include <cstdlib>
 #endif
 
+#include <map>
+#include <set>
 #include <stack>
+#include <vector>
 
+#include "eixTk/dialect.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "search/algorithms.h"
 #include "search/packagetest.h"
 
+using std::vector;
+
 bool MatchAtom::match(PackageReader * /* p */) {
 #ifdef DEBUG_MATCHTREE
 	eix::print(m_negate ? " '!' " : " '' ");
@@ -271,6 +278,7 @@ void MatchTree::parse_close() {
 }
 
 void MatchTree::end_parse() {
+	bool parsing(!parser_stack.empty());
 	parse_local_negate();
 	while(!parser_stack.empty()) {
 		parse_closeforce();
@@ -284,5 +292,131 @@ void MatchTree::end_parse() {
 	}
 	std::exit(EXIT_SUCCESS);
 #endif
+	if(parsing) {
+		combine_tests(&root);
+	}
+}
+
+void MatchTree::collect_or(MatchAtom *atom, vector<MatchAtom *> *leaves, vector<MatchAtomOperator *> *ops) {
+	MatchAtomOperator *op((atom == NULLPTR) ? NULLPTR : atom->as_operator());
+	if((op == NULLPTR) || (op->m_operator != MatchAtomOperator::AtomOr) ||
+		op->m_negate) {
+		leaves->PUSH_BACK(atom);
+		return;
+	}
+	ops->PUSH_BACK(op);
+	collect_or(op->m_left, leaves, ops);
+	collect_or(op->m_right, leaves, ops);
+}
+
+bool MatchTree::has_side_effects(MatchAtom *atom) {
+	if(atom == NULLPTR) {
+		return false;
+	}
+	MatchAtomOperator *op(atom->as_operator());
+	if(op != NULLPTR) {
+		return (has_side_effects(op->m_left) || has_side_effects(op->m_right));
+	}
+	MatchAtomTest *t(atom->as_test());
+	return ((t != NULLPTR) && (t->m_test != NULLPTR) && t->m_test->has_side_effects());
+}
+
+bool MatchTree::requires_installed(MatchAtom *atom) {
+	if((atom == NULLPTR) || atom->m_negate) {
+		return false;
+	}
+	MatchAtomOperator *op(atom->as_operator());
+	if(op != NULLPTR) {
+		if(op->m_operator == MatchAtomOperator::AtomAnd) {
+			return (requires_installed(op->m_left) || requires_installed(op->m_right));
+		}
+		return (requires_installed(op->m_left) && requires_installed(op->m_right));
+	}
+	MatchAtomTest *t(atom->as_test());
+	return ((t != NULLPTR) && (t->m_test != NULLPTR) && t->m_test->requires_installed());
+}
+
+void MatchTree::combine_tests(MatchAtom **atom) {
+	MatchAtomOperator *op((*atom == NULLPTR) ? NULLPTR : (*atom)->as_operator());
+	if(op == NULLPTR) {
+		return;
+	}
+	if((op->m_operator != MatchAtomOperator::AtomOr) || op->m_negate) {
+		combine_tests(&(op->m_left));
+		combine_tests(&(op->m_right));
+		return;
+	}
+	vector<MatchAtom *> leaves;
+	vector<MatchAtomOperator *> ops;
+	collect_or(op, &leaves, &ops);
+	bool combinable(true);
+	for(vector<MatchAtom *>::iterator it(leaves.begin());
+		likely(it != leaves.end()); ++it) {
+		// An empty alternative matches always; reordered side effects
+		// (of fuzzy search) might change the result:
+		// In both cases we keep the alternatives as they are.
+		if((*it == NULLPTR) || has_side_effects(*it)) {
+			combinable = false;
+		}
+		combine_tests(&(*it));
+	}
+	if(!combinable) {
+		return;
+	}
+
+	// Group the combinable tests by field, keeping the first test of each group
+	typedef std::map<PackageTest::MatchField, vector<MatchAtomTest *> > Groups;
+	Groups groups;
+	for(vector<MatchAtom *>::iterator it(leaves.begin());
+		likely(it != leaves.end()); ++it) {
+		MatchAtomTest *t((*it)->as_test());
+		if((t == NULLPTR) || t->m_negate || (t->m_pipe != NULLPTR) ||
+			(t->m_test == NULLPTR) || !(t->m_test->is_combinable())) {
+			continue;
+		}
+		groups[t->m_test->get_field()].PUSH_BACK(t);
+	}
+	std::set<MatchAtom *> merged;
+	for(Groups::iterator g(groups.begin()); likely(g != groups.end()); ++g) {
+		vector<MatchAtomTest *>& tests(g->second);
+		if(tests.size() < 2) {
+			continue;
+		}
+		MultiAlgorithm *multi(new MultiAlgorithm);
+		for(vector<MatchAtomTest *>::iterator it(tests.begin());
+			likely(it != tests.end()); ++it) {
+			(*it)->m_test->add_pattern(multi);
+		}
+		multi->finalize();
+		tests[0]->m_test->setAlgorithm(multi);
+		merged.insert(tests.begin() + 1, tests.end());
+	}
+	if(merged.empty()) {
+		return;
+	}
+
+	// Rebuild the or-group from the remaining alternatives
+	for(vector<MatchAtomOperator *>::iterator it(ops.begin());
+		likely(it != ops.end()); ++it) {
+		(*it)->m_left = (*it)->m_right = NULLPTR;
+		delete *it;
+	}
+	MatchAtom *result(NULLPTR);
+	for(vector<MatchAtom *>::iterator it(leaves.begin());
+		likely(it != leaves.end()); ++it) {
+		if(merged.count(*it) != 0) {
+			delete *it;
+			continue;
+		}
+		if(result == NULLPTR) {
+			result = *it;
+			continue;
+		}
+		MatchAtomOperator *o(new MatchAtomOperator(MatchAtomOperator::AtomOr));
+		o->m_left = result;
+		o->m_right = *it;
+		result = o;
+	}
+	*atom = result;
 }
 
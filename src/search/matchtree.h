@@ -11,6 +11,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <stack>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
@@ -56,7 +57,7 @@ class MatchAtom {
 		}
 };
 
-class MatchAtomOperator : public MatchAtom {
+class MatchAtomOperator FINAL : public MatchAtom {
 		friend class MatchTree;
 	private:
 		enum AtomOperator { AtomAnd, AtomOr };
@@ -77,7 +78,7 @@ class MatchAtomOperator : public MatchAtom {
 		}
 };
 
-class MatchAtomTest : public MatchAtom {
+class MatchAtomTest FINAL : public MatchAtom {
 		friend class MatchTree;
 	private:
 		PackageTest *m_test;
@@ -169,6 +170,21 @@ class MatchTree {
 		**/
 		void parse_closeforce();
 
+		/**
+		Merge combinable string tests on the same field within each
+		group of alternatives into a single test (recursively).
+		**/
+		static void combine_tests(MatchAtom **atom);
+
+		/**
+		Collect the alternatives of a (non-negated) or-group
+		**/
+		ATTRIBUTE_NONNULL_ static void collect_or(MatchAtom *atom, std::vector<MatchAtom *> *leaves, std::vector<MatchAtomOperator *> *ops);
+
+		static bool has_side_effects(MatchAtom *atom);
+
+		static bool requires_installed(MatchAtom *atom);
+
 	public:
 		explicit MatchTree(bool default_is_or);
 
@@ -176,6 +192,13 @@ class MatchTree {
 
 		bool match(PackageReader *p);
 
+		/**
+		@return true if only installed packages can match
+		**/
+		bool requires_installed() const {
+			return requires_installed(root);
+		}
+
 		void set_pipetest(PackageTest *gtest);
 
 		void parse_test(PackageTest *gtest, bool with_pipe);
@@ -191,6 +191,44 @@ void PackageTest::finalize() {
 	calculateNeeds();
 }
 
+bool PackageTest::is_combinable() const {
+	if((algorithm == NULLPTR) ||
+		(algorithm->combine() == BaseAlgorithm::COMBINE_NONE)) {
+		return false;
+	}
+	// stringMatch() simplifies the search string lazily with the first
+	// simplified field it tests: Only combine if no field is ever tested
+	// with the unsimplified string.
+	if(simplified_field() && ((field & NAME) == NONE) &&
+		((field & (DESCRIPTION | LICENSE)) != NONE)) {
+		return false;
+	}
+	return !(overlay || obsolete || upgrade ||
+		installed || slotted || world || worldset ||
+		have_virtual || have_nonvirtual ||
+		dup_versions || dup_packages ||
+		(binarynum != 0) ||
+		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
+		(properties != ExtendedVersion::PROPERTIES_NONE) ||
+		(overlay_list != NULLPTR) || (overlay_only_list != NULLPTR) ||
+		(in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR) ||
+		(marked_list != NULLPTR) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE) ||
+		(test_instability != STABLE_NONE));
+}
+
+bool PackageTest::has_side_effects() const {
+	return ((algorithm != NULLPTR) && algorithm->has_side_effects());
+}
+
+void PackageTest::add_pattern(MultiAlgorithm *multi) {
+	multi->add(algorithm->combine(), algorithm->get_string(simplified_field()));
+}
+
 /**
 @return true if pkg matches test
 **/
@@ -263,6 +301,7 @@ bool PackageTest::stringMatch(Package *pkg) const {
 	}
 
 	if((field & SET) != NONE) {
+		pkg->finalize_local();
 		WordSet setnames;
 		portagesettings->get_setnames(&setnames, pkg);
 		for(WordSet::const_iterator it(setnames.begin());
@@ -780,6 +819,9 @@ bool PackageTest::match(PackageReader *pkg) const {
 			get_nowarn_list();
 		}
 		get_p(&p, pkg);
+		// The flags are modified without SetStability
+		p->finalize_local();
+		p->stability_key = BestCache::KEY_UNKNOWN;
 		Keywords::Redundant rflags(redundant_flags);
 		TestInstalled test_ins(test_installed);
 		nowarn_list->apply(p, &rflags, &test_ins, portagesettings);
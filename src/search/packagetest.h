@@ -32,6 +32,7 @@ class BaseAlgorithm;
 class Mask;
 class MatcherAlgorithm;
 class MatcherField;
+class MultiAlgorithm;
 class NowarnMaskList;
 class ParseError;
 class PortageSettings;
@@ -133,6 +134,33 @@ class PackageTest {
 		**/
 		void finalize();
 
+		MatchField get_field() const {
+			return field;
+		}
+
+		/**
+		@return true if this is a pure string test whose pattern can be
+		merged with those of other such tests on the same field
+		**/
+		bool is_combinable() const;
+
+		/**
+		@return true if matching has effects beyond the result
+		**/
+		bool has_side_effects() const;
+
+		/**
+		Add our pattern to multi. Only call if is_combinable()
+		**/
+		ATTRIBUTE_NONNULL_ void add_pattern(MultiAlgorithm *multi);
+
+		/**
+		@return true if only installed packages can match
+		**/
+		bool requires_installed() const {
+			return installed;
+		}
+
 		/*
 		The constructor of the class *must* set the least restrictive choice.
 		Since --selected --world must act like --selected, the less restrictive
@@ -383,6 +411,13 @@ class PackageTest {
 
 		ATTRIBUTE_NONNULL_ bool stringMatch(Package *pkg) const;
 
+		/**
+		@return true if stringMatch() uses the simplified search string
+		**/
+		bool simplified_field() const {
+			return ((field & (NAME | CATEGORY | CATEGORY_NAME)) != NONE);
+		}
+
 		void setNeeds(const PackageReader::Attributes i) {
 			if(need < i) {
 				need = i;
@@ -40,6 +40,7 @@ enum cli_options {
 	O_FMT = 256,
 	O_XML,
 	O_PROTO,
+	O_JSON,
 	O_PRINT_VAR,
 	O_PIPE_MASK,
 	O_ANSI,
@@ -0,0 +1,275 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#include "various/query_cache.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "database/header.h"
+#include "eixTk/dialect.h"
+#include "eixTk/formated.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/outputsink.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/utils.h"
+#include "eixrc/eixrc.h"
+#include "portage/conf/portagesettings.h"
+#include "portage/overlay.h"
+
+extern char **environ;
+
+using std::string;
+
+/**
+Maximal depth of subdirectories of /etc/portage which are considered
+**/
+static CONSTEXPR const unsigned int etc_portage_depth = 16;
+
+QueryCache *QueryCache::capturing = NULLPTR;
+
+static int all_selector(SCANDIR_ARG3 /* dent */) {
+	return 1;
+}
+
+/**
+FNV-1a; the name need not be unique since the key is stored in the file
+**/
+static string hash_name(const string& s) {
+	uint32_t h(2166136261U);
+	for(string::const_iterator it(s.begin()); likely(it != s.end()); ++it) {
+		h ^= static_cast<unsigned char>(*it);
+		h *= 16777619U;
+	}
+	static CONSTEXPR const char hex[] = "0123456789abcdef";
+	string r;
+	for(int i(28); i >= 0; i -= 4) {
+		r.append(1, hex[(h >> i) & 0xF]);
+	}
+	return r;
+}
+
+static bool write_all(int fd, const char *buf, size_t len) {
+	while(len != 0) {
+		ssize_t w(write(fd, buf, len));
+		if(unlikely(w <= 0)) {
+			return false;
+		}
+		buf += w;
+		len -= w;
+	}
+	return true;
+}
+
+bool QueryCache::add_stat(const char *file) {
+	struct stat st;
+	if(stat(file, &st) != 0) {
+		m_key.append("-\0", 2);
+		return false;
+	}
+	add_string(eix::format("%s %s %s %s %s")
+		% st.st_dev % st.st_ino % st.st_size % st.st_mtime % st.st_ctime);
+	return true;
+}
+
+void QueryCache::add_tree(const string& dir, unsigned int depth) {
+	add_string(dir);
+	if(!add_stat(dir.c_str()) || (depth == 0)) {
+		return;
+	}
+	WordVec names;
+	if(!scandir_cc(dir, &names, all_selector)) {
+		return;
+	}
+	for(WordVec::const_iterator it(names.begin());
+		likely(it != names.end()); ++it) {
+		string name(dir + "/" + (*it));
+		struct stat st;
+		// Do not descend into symlinks like make.profile
+		if((lstat(name.c_str(), &st) == 0) && S_ISDIR(st.st_mode)) {
+			add_tree(name, depth - 1);
+		} else {
+			add_string(name);
+			add_stat(name.c_str());
+		}
+	}
+}
+
+bool QueryCache::init(const string& dir, int argc, const char *const *argv, bool is_tty, const string& cachefile, EixRc *eixrc, const PortageSettings *portagesettings) {
+	m_key.assign(PACKAGE_VERSION);
+	m_key.append(1, '\0');
+	add_string(eix::format("%s %s") % DBHeader::current % (is_tty ? 1 : 0));
+	m_key.append("args\0", 5);
+	for(int i(1); i < argc; ++i) {
+		add_string(argv[i]);
+	}
+	m_key.append("env\0", 4);
+	WordVec env;
+	for(char **e(environ); likely(*e != NULLPTR); ++e) {
+		env.PUSH_BACK(*e);
+	}
+	std::sort(env.begin(), env.end());
+	for(WordVec::const_iterator it(env.begin()); likely(it != env.end()); ++it) {
+		add_string(*it);
+	}
+	m_key.append("eixrc\0", 6);
+	eixrc->append_config(&m_key);
+
+	// Everything up to here identifies the query; a changed state
+	// of the system below replaces the previous result of the query.
+	m_filename = dir + "/" + hash_name(m_key);
+
+	m_key.append("cache\0", 6);
+	if(!add_stat(cachefile.c_str())) {
+		return false;
+	}
+	const string& eprefixconf(portagesettings->m_eprefixconf);
+	m_key.append("config\0", 7);
+	add_tree(eprefixconf + "/etc/portage", etc_portage_depth);
+	add_stat((eprefixconf + MAKE_CONF_FILE).c_str());
+	add_stat((eprefixconf + MAKE_GLOBALS_FILE).c_str());
+	add_stat((*eixrc)["MAKE_GLOBALS"].c_str());
+	add_stat((*eixrc)["PORTAGE_REPOS_CONF"].c_str());
+	m_key.append("profile\0", 8);
+	const WordVec& profile_dirs(portagesettings->profile_dirs);
+	for(WordVec::const_iterator it(profile_dirs.begin());
+		likely(it != profile_dirs.end()); ++it) {
+		add_tree(*it, 2);
+	}
+	const RepoList& repos(portagesettings->repos);
+	for(RepoList::const_iterator it(repos.begin()); likely(it != repos.end()); ++it) {
+		add_tree(it->path + "/profiles", 1);
+	}
+	m_key.append("installed\0", 10);
+	add_tree((*eixrc)["EPREFIX_INSTALLED"] + "/var/db/pkg", 1);
+	add_stat((*eixrc)["EIX_WORLD"].c_str());
+	add_stat((*eixrc)["EIX_WORLD_SETS"].c_str());
+	return true;
+}
+
+bool QueryCache::serve(int *status) const {
+	FILE *fp(std::fopen(m_filename.c_str(), "rb"));
+	if(fp == NULLPTR) {
+		return false;
+	}
+	unsigned long len;  // NOLINT(runtime/int)
+	bool valid((std::fscanf(fp, "%lu\n", &len) == 1) && (len == m_key.size()));
+	if(likely(valid)) {
+		string key(len, '\0');
+		char code[4];
+		valid = ((std::fread(&(key[0]), 1, len, fp) == len) && (key == m_key) &&
+			(std::fread(code, 1, 4, fp) == 4) && (code[3] == '\n'));
+		if(likely(valid)) {
+			code[3] = '\0';
+			*status = std::atoi(code);
+		}
+	}
+	if(unlikely(!valid)) {
+		std::fclose(fp);
+		return false;
+	}
+	char buf[8192];
+	size_t r;
+	while((r = std::fread(buf, 1, sizeof(buf), fp)) != 0) {
+		OutputSink::write(buf, r);
+	}
+	std::fclose(fp);
+	OutputSink::flush();
+	return true;
+}
+
+bool QueryCache::capture() {
+	string temp(m_filename + ".XXXXXX");
+	m_temp_fd = mkstemp(&(temp[0]));
+	if(m_temp_fd == -1) {
+		return false;
+	}
+	m_tempname = temp;
+	string header(eix::format("%s\n") % m_key.size());
+	header.append(m_key);
+	header.append("000\n");
+	m_status_pos = header.size() - 4;
+	OutputSink::flush();
+	std::cout.flush();
+	if(unlikely(!write_all(m_temp_fd, header.c_str(), header.size())) ||
+		unlikely((m_saved_stdout = dup(1)) == -1)) {
+		remove_tempfile();
+		return false;
+	}
+	if(unlikely(dup2(m_temp_fd, 1) == -1)) {
+		close(m_saved_stdout);
+		m_saved_stdout = -1;
+		remove_tempfile();
+		return false;
+	}
+	static bool registered(false);
+	if(!registered) {
+		registered = true;
+		std::atexit(exit_handler);
+	}
+	capturing = this;
+	return true;
+}
+
+void QueryCache::exit_handler() {
+	if(unlikely(capturing != NULLPTR)) {
+		capturing->finish(-1);
+	}
+}
+
+void QueryCache::remove_tempfile() {
+	close(m_temp_fd);
+	m_temp_fd = -1;
+	unlink(m_tempname.c_str());
+}
+
+void QueryCache::finish(int status) {
+	capturing = NULLPTR;
+	OutputSink::flush();
+	std::cout.flush();
+	dup2(m_saved_stdout, 1);
+	close(m_saved_stdout);
+	m_saved_stdout = -1;
+
+	// Store the entry before printing: The output might be interrupted.
+	bool stored(false);
+	if(likely((status >= 0) && (status <= 255))) {
+		char code[3] = {
+			static_cast<char>('0' + status / 100),
+			static_cast<char>('0' + (status / 10) % 10),
+			static_cast<char>('0' + status % 10)
+		};
+		stored = ((pwrite(m_temp_fd, code, 3, m_status_pos) == 3) &&
+			(rename(m_tempname.c_str(), m_filename.c_str()) == 0));
+	}
+	if(unlikely(!stored)) {
+		unlink(m_tempname.c_str());
+	}
+	if(likely(lseek(m_temp_fd, m_status_pos + 4, SEEK_SET) != -1)) {
+		char buf[8192];
+		ssize_t r;
+		while((r = read(m_temp_fd, buf, sizeof(buf))) > 0) {
+			if(unlikely(!write_all(1, buf, r))) {
+				break;
+			}
+		}
+	}
+	close(m_temp_fd);
+	m_temp_fd = -1;
+}
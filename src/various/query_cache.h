@@ -0,0 +1,91 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   Martin Väth <martin@mvath.de>
+
+#ifndef SRC_VARIOUS_QUERY_CACHE_H_
+#define SRC_VARIOUS_QUERY_CACHE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/types.h>
+
+#include <string>
+
+#include "eixTk/attribute.h"
+
+class EixRc;
+class PortageSettings;
+
+/**
+Store the output of a query in a file whose validity is determined by
+the command line and by fingerprints of the eix cache, the configuration,
+the profile, and the installed packages.
+**/
+class QueryCache {
+	private:
+		std::string m_key, m_filename, m_tempname;
+		int m_saved_stdout, m_temp_fd;
+		off_t m_status_pos;
+
+		/**
+		The entry whose capture is in progress, for exit_handler()
+		**/
+		static QueryCache *capturing;
+
+		void add_string(const std::string& s) {
+			m_key.append(s);
+			m_key.append(1, '\0');
+		}
+
+		/**
+		Add the stat data of file to the key
+		@return false if file does not exist
+		**/
+		ATTRIBUTE_NONNULL_ bool add_stat(const char *file);
+
+		/**
+		Add the stat data of dir and (up to depth) of its entries to the key
+		**/
+		void add_tree(const std::string& dir, unsigned int depth);
+
+		void remove_tempfile();
+
+	public:
+		QueryCache() : m_saved_stdout(-1), m_temp_fd(-1), m_status_pos(0) {
+		}
+
+		/**
+		Calculate the key for the query
+		@return false if the query cannot be cached
+		**/
+		ATTRIBUTE_NONNULL_ bool init(const std::string& dir, int argc, const char *const *argv, bool is_tty, const std::string& cachefile, EixRc *eixrc, const PortageSettings *portagesettings);
+
+		/**
+		Print the stored output if there is a valid one
+		@return true if the output was printed
+		**/
+		ATTRIBUTE_NONNULL_ bool serve(int *status) const;
+
+		/**
+		Redirect stdout into a new cache entry
+		@return false if this is not possible
+		**/
+		bool capture();
+
+		/**
+		Stop the redirection, store the entry, and print its output
+		@param status exit status; the entry is not stored if out of range
+		**/
+		void finish(int status);
+
+		/**
+		Called at exit: If a capture is still in progress (e.g. since
+		std::exit() was called), print its output without storing it
+		**/
+		static void exit_handler();
+};
+
+#endif  // SRC_VARIOUS_QUERY_CACHE_H_